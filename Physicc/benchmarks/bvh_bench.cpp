@@ -0,0 +1,211 @@
+/**
+ * @file bvh_bench.cpp
+ * @brief Benchmarks of BVH builds, refits and overlap queries.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* benchmark header */
+
+#include "tools/Tracy.hpp"
+
+#include "benchmark/benchmark.h"
+#include "bvh.hpp"
+#include "scenes.hpp"
+
+#include <iterator>
+
+namespace PhysiccBench
+{
+	namespace
+	{
+		const std::vector<std::int64_t> bodyCounts = {1 << 10, 1 << 14,
+		                                              1 << 17, 1 << 20};
+		const std::vector<std::int64_t> scenes = {e_uniform, e_clustered};
+
+		/**
+		 * @brief Boxes to query a scene of bodyCount bodies with: unit
+		 * boxes spread over the same space as its uniform layout
+		 */
+		std::vector<Physicc::BoundingVolume::AABB>
+		makeQueries(std::size_t count, std::size_t bodyCount)
+		{
+			auto bodies = makeBodies(e_uniform, bodyCount, 7);
+			std::vector<Physicc::BoundingVolume::AABB> queries;
+			queries.reserve(count);
+
+			for (std::size_t i = 0; i < count && i < bodies.size(); i++)
+			{
+				queries.push_back(bodies[i].getAABB());
+			}
+
+			return queries;
+		}
+	}
+
+	/**
+	 * @brief Builds a BVH from scratch with each builder, with and without
+	 * treelet restructuring
+	 *
+	 * The bodies are copied back in their original order before every
+	 * build (outside of the timing), since a build reorders them. The cost
+	 * counter is the sum of the surface areas of the internal nodes, which
+	 * queries scale with: lower is a better tree.
+	 */
+	void BVHBuild(benchmark::State& state)
+	{
+		auto builder = static_cast<Physicc::BVH::Builder>(state.range(0));
+		auto scene = static_cast<Scene>(state.range(2));
+		auto count = static_cast<std::size_t>(state.range(3));
+		auto bodies = makeBodies(scene, count);
+		Physicc::BVH bvh(bodies, builder);
+		bvh.setTreeletRestructuring(state.range(1) != 0);
+
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+
+			for (std::size_t i = 0; i < bodies.size(); i++)
+			{
+				bvh.getRigidBody(i) = bodies[i];
+			}
+
+			state.ResumeTiming();
+
+			bvh.buildTree();
+			benchmark::DoNotOptimize(bvh.convert().data());
+		}
+
+		double cost = 0.0;
+
+		for (const auto& node : bvh.convert())
+		{
+			if (!node.isLeaf())
+			{
+				cost += node.volume.getSurfaceArea();
+			}
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(3));
+		state.counters["cost"] = cost;
+		state.SetLabel(getSceneName(scene));
+	}
+
+	BENCHMARK(BVHBuild)
+		->ArgNames({"builder", "restructure", "scene", "bodies"})
+		->ArgsProduct({{Physicc::BVH::e_median, Physicc::BVH::e_binnedSAH,
+		                Physicc::BVH::e_lbvh},
+		               {0, 1}, scenes, bodyCounts})
+		->Unit(benchmark::kMillisecond)
+		->UseRealTime();
+
+	/**
+	 * @brief Refits a built tree to bodies that all moved a little
+	 */
+	void BVHRefit(benchmark::State& state)
+	{
+		auto scene = static_cast<Scene>(state.range(0));
+		auto count = static_cast<std::size_t>(state.range(1));
+		Physicc::BVH bvh(makeBodies(scene, count));
+		bvh.buildTree();
+
+		float offset = 0.01f;
+
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+
+			for (std::size_t i = 0; i < bvh.getRigidBodyList().size(); i++)
+			{
+				auto& body = bvh.getRigidBody(i);
+				auto shape = body.getShape();
+				auto& collider = shape.get();
+				collider.setPosition(collider.getPosition() + offset);
+				body.setCollider(shape);
+			}
+
+			offset = -offset;
+			state.ResumeTiming();
+
+			bvh.refit();
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(1));
+		state.SetLabel(getSceneName(scene));
+	}
+
+	BENCHMARK(BVHRefit)
+		->ArgNames({"scene", "bodies"})
+		->ArgsProduct({scenes, bodyCounts})
+		->Unit(benchmark::kMillisecond);
+
+	/**
+	 * @brief Finds every overlapping pair of a built tree
+	 */
+	void BVHFindPairs(benchmark::State& state)
+	{
+		auto scene = static_cast<Scene>(state.range(0));
+		auto count = static_cast<std::size_t>(state.range(1));
+		Physicc::BVH bvh(makeBodies(scene, count));
+		bvh.buildTree();
+
+		std::vector<Physicc::CollisionPair> pairs;
+		Physicc::BVH::QueryScratch scratch;
+
+		for (auto _ : state)
+		{
+			bvh.findPairs(pairs, scratch);
+			benchmark::DoNotOptimize(pairs.data());
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(1));
+		state.counters["pairs"] = static_cast<double>(pairs.size());
+		state.SetLabel(getSceneName(scene));
+	}
+
+	BENCHMARK(BVHFindPairs)
+		->ArgNames({"scene", "bodies"})
+		->ArgsProduct({scenes, bodyCounts})
+		->Unit(benchmark::kMillisecond);
+
+	/**
+	 * @brief Runs 1024 box overlap queries against a built tree
+	 */
+	void BVHQueryOverlaps(benchmark::State& state)
+	{
+		constexpr std::size_t queryCount = 1024;
+
+		auto scene = static_cast<Scene>(state.range(0));
+		auto count = static_cast<std::size_t>(state.range(1));
+		Physicc::BVH bvh(makeBodies(scene, count));
+		bvh.buildTree();
+
+		auto queries = makeQueries(queryCount,
+		                           static_cast<std::size_t>(state.range(1)));
+		std::vector<std::size_t> hits;
+		Physicc::BVH::QueryScratch scratch;
+
+		for (auto _ : state)
+		{
+			hits.clear();
+
+			for (const auto& query : queries)
+			{
+				bvh.queryOverlaps(query, std::back_inserter(hits), scratch);
+			}
+
+			benchmark::DoNotOptimize(hits.data());
+		}
+
+		state.SetItemsProcessed(state.iterations() *
+		                        static_cast<std::int64_t>(queries.size()));
+		state.counters["hits"] = static_cast<double>(hits.size());
+		state.SetLabel(getSceneName(scene));
+	}
+
+	BENCHMARK(BVHQueryOverlaps)
+		->ArgNames({"scene", "bodies"})
+		->ArgsProduct({scenes, bodyCounts})
+		->Unit(benchmark::kMicrosecond);
+}
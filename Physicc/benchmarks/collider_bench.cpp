@@ -0,0 +1,65 @@
+/**
+ * @file collider_bench.cpp
+ * @brief Benchmarks of collider bounding box computations.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* benchmark header */
+
+#include "tools/Tracy.hpp"
+
+#include "benchmark/benchmark.h"
+#include "collider.hpp"
+
+#include <random>
+#include <vector>
+
+namespace PhysiccBench
+{
+	/**
+	 * @brief Computes the world AABB of many rotated, scaled boxes, as the
+	 * broadphase does for every awake body each step
+	 */
+	void BoxColliderGetAABB(benchmark::State& state)
+	{
+		auto count = static_cast<std::size_t>(state.range(0));
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		auto random = [&]() {
+			return glm::vec3(unit(generator), unit(generator), unit(generator));
+		};
+
+		std::vector<Physicc::BoxCollider> colliders;
+		colliders.reserve(count);
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			glm::vec3 position = random();
+			glm::vec3 rotation = random();
+			glm::vec3 scale(1.5f + unit(generator), 1.5f + unit(generator),
+			                1.5f + unit(generator));
+
+			colliders.emplace_back(position * 100.0f, rotation * 3.14f, scale);
+		}
+
+		for (auto _ : state)
+		{
+			for (const auto& collider : colliders)
+			{
+				auto volume = collider.getAABB();
+				benchmark::DoNotOptimize(volume);
+			}
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	BENCHMARK(BoxColliderGetAABB)
+		->ArgName("colliders")
+		->RangeMultiplier(16)
+		->Range(1 << 10, 1 << 18)
+		->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file integrator_bench.cpp
+ * @brief Benchmarks of the semi-implicit Euler integrator.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* benchmark header */
+
+#include "tools/Tracy.hpp"
+
+#include "benchmark/benchmark.h"
+#include "bodystorage.hpp"
+#include "integrator.hpp"
+#include "scenes.hpp"
+
+namespace PhysiccBench
+{
+	/**
+	 * @brief Integrates every body of a storage, on its own, without the
+	 * rest of a step around it
+	 */
+	void Integrate(benchmark::State& state)
+	{
+		constexpr float timestep = 1.0f / 60.0f;
+
+		auto count = static_cast<std::size_t>(state.range(0));
+		Physicc::BodyStorage bodies;
+		bodies.reserve(count);
+
+		for (const auto& body : makeBodies(e_uniform, count))
+		{
+			bodies.add(body);
+		}
+
+		for (auto _ : state)
+		{
+			Physicc::integrate(bodies, glm::vec3(0.0f, -9.81f, 0.0f), timestep);
+			benchmark::DoNotOptimize(bodies.getPositions().data());
+			benchmark::ClobberMemory();
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	BENCHMARK(Integrate)
+		->ArgName("bodies")
+		->Arg(10000)
+		->Arg(100000)
+		->Arg(1000000)
+		->Unit(benchmark::kMicrosecond);
+}
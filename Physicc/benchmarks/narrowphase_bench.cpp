@@ -0,0 +1,129 @@
+/**
+ * @file narrowphase_bench.cpp
+ * @brief Benchmarks of contact generation, per pair of shapes.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* benchmark header */
+
+#include "tools/Tracy.hpp"
+
+#include "benchmark/benchmark.h"
+#include "narrowphase.hpp"
+
+#include <random>
+#include <vector>
+
+namespace PhysiccBench
+{
+	enum PairType
+	{
+		e_boxBox = 0,
+		e_boxSphere = 1,
+		e_sphereSphere = 2
+	};
+
+	inline const char* getPairName(PairType type)
+	{
+		switch (type)
+		{
+			case e_boxBox:
+				return "box-box";
+			case e_boxSphere:
+				return "box-sphere";
+			default:
+				return "sphere-sphere";
+		}
+	}
+
+	/**
+	 * @brief Makes count pairs of unit shapes, each placed at a random
+	 * offset and rotation from the other, close enough that most touch
+	 */
+	std::vector<Physicc::ColliderShape> makePairs(PairType type,
+	                                              std::size_t count)
+	{
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<Physicc::ColliderShape> colliders;
+		colliders.reserve(2 * count);
+
+		auto random = [&]() {
+			return glm::vec3(unit(generator), unit(generator), unit(generator));
+		};
+
+		auto makeShape = [&](bool box, const glm::vec3& position) {
+			glm::vec3 rotation = 180.0f * random();
+
+			if (box)
+			{
+				return Physicc::ColliderShape(
+					Physicc::BoxCollider(position, rotation));
+			}
+
+			return Physicc::ColliderShape(
+				Physicc::SphereCollider(0.5f, position));
+		};
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			//spread the pairs out, so they don't all sit in the cache
+			glm::vec3 position = 100.0f * random();
+			glm::vec3 offset = 0.6f * random();
+
+			colliders.push_back(makeShape(type != e_sphereSphere, position));
+			colliders.push_back(makeShape(type == e_boxBox, position + offset));
+		}
+
+		return colliders;
+	}
+
+	/**
+	 * @brief Collides a prebuilt list of pairs of one shape combination
+	 */
+	void NarrowphaseCollide(benchmark::State& state)
+	{
+		auto type = static_cast<PairType>(state.range(0));
+		auto count = static_cast<std::size_t>(state.range(1));
+		auto colliders = makePairs(type, count);
+
+		Physicc::Narrowphase narrowphase;
+		Physicc::ContactManifold manifold;
+		std::int64_t contacts = 0;
+		std::int64_t touching = 0;
+
+		for (auto _ : state)
+		{
+			touching = 0;
+
+			for (std::size_t i = 0; i < count; i++)
+			{
+				manifold.first = 2 * i;
+				manifold.second = 2 * i + 1;
+
+				if (narrowphase.collide(colliders[2 * i].get(),
+				                        colliders[2 * i + 1].get(), manifold))
+				{
+					contacts += manifold.pointCount;
+					touching++;
+				}
+			}
+
+			benchmark::DoNotOptimize(manifold);
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(1));
+		state.counters["contacts"] = benchmark::Counter(
+			static_cast<double>(contacts), benchmark::Counter::kIsRate);
+		state.counters["touching"] = static_cast<double>(touching);
+		state.SetLabel(getPairName(type));
+	}
+
+	BENCHMARK(NarrowphaseCollide)
+		->ArgNames({"pair", "pairs"})
+		->ArgsProduct({{e_boxBox, e_boxSphere, e_sphereSphere},
+		               {1 << 10, 1 << 16}})
+		->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,162 @@
+#ifndef __SCENES_H__
+#define __SCENES_H__
+
+#include "tools/Tracy.hpp"
+
+#include "glm/glm.hpp"
+#include "physicsworld.hpp"
+#include "rigidbody.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace PhysiccBench
+{
+	/**
+	 * @brief Synthetic scenes the benchmarks run on
+	 *
+	 * e_uniform scatters unit boxes with the same density whatever their
+	 * number, e_clustered packs them into dense clumps far apart from each
+	 * other, and e_stacked piles them into columns resting on a ground, so
+	 * that every body has contacts.
+	 */
+	enum Scene
+	{
+		e_uniform = 0,
+		e_clustered = 1,
+		e_stacked = 2,
+		e_typecount = 3
+	};
+
+	inline const char* getSceneName(Scene scene)
+	{
+		switch (scene)
+		{
+			case e_uniform:
+				return "uniform";
+			case e_clustered:
+				return "clustered";
+			default:
+				return "stacked";
+		}
+	}
+
+	constexpr int stackHeight = 10;
+	constexpr std::size_t clusterSize = 64;
+
+	/**
+	 * @brief Makes count unit boxes laid out as in scene
+	 *
+	 * The layout only depends on the arguments, so runs can be compared.
+	 * Boxes of uniform and clustered scenes get a small random velocity,
+	 * so that they keep moving (and the broadphase keeps working) when
+	 * stepped without gravity.
+	 */
+	inline std::vector<Physicc::RigidBody> makeBodies(Scene scene,
+	                                                  std::size_t count,
+	                                                  std::uint32_t seed = 42)
+	{
+		std::mt19937 generator(seed);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+
+		auto randomUnit = [&]() {
+			return glm::vec3(unit(generator), unit(generator), unit(generator));
+		};
+
+		auto randomNormal = [&]() {
+			return glm::vec3(normal(generator), normal(generator),
+			                 normal(generator));
+		};
+
+		std::vector<Physicc::RigidBody> bodies;
+		bodies.reserve(count);
+
+		//about 8 units of volume per body, i.e. a box every 2 units
+		float side = 2.0f * std::cbrt(static_cast<float>(count));
+		glm::vec3 clusterCenter(0.0f);
+		auto columns = static_cast<std::size_t>(std::ceil(
+			std::sqrt(static_cast<float>(count) / stackHeight)));
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			glm::vec3 position;
+			glm::vec3 velocity(0.0f);
+
+			switch (scene)
+			{
+				case e_uniform:
+					position = randomUnit() * (side * 0.5f);
+					velocity = randomUnit();
+					break;
+				case e_clustered:
+					if (i % clusterSize == 0)
+					{
+						clusterCenter = randomUnit() * (side * 2.0f);
+					}
+					//spread out 8 times more than uniform, so as empty
+					//overall, but crowded around the clusters
+
+					position = clusterCenter + 1.5f * randomNormal();
+					velocity = randomUnit();
+					break;
+				default:
+				{
+					std::size_t column = i / stackHeight;
+					std::size_t level = i % stackHeight;
+					position = glm::vec3(
+						2.0f * static_cast<float>(column % columns),
+						0.5f + static_cast<float>(level),
+						2.0f * static_cast<float>(column / columns));
+					break;
+				}
+			}
+
+			Physicc::RigidBody body(1.0f, velocity, 1.0f);
+			body.setCollider(Physicc::BoxCollider(position));
+			bodies.push_back(body);
+		}
+
+		return bodies;
+	}
+
+	/**
+	 * @brief Fills a world with a scene
+	 *
+	 * Stacked scenes get a static ground under the columns and gravity,
+	 * the others no gravity, so that they don't all end up in one pile.
+	 * Sleeping is turned off, so that steps keep doing all of their work
+	 * however long they are measured for.
+	 */
+	inline void populateWorld(Physicc::PhysicsWorld& world, Scene scene,
+	                          std::size_t count)
+	{
+		world.setTimeToSleep(std::numeric_limits<float>::infinity());
+
+		if (scene == e_stacked)
+		{
+			world.setGravity(glm::vec3(0.0f, -9.81f, 0.0f));
+
+			float side = 4.0f
+				* std::sqrt(static_cast<float>(count) / stackHeight) + 4.0f;
+			Physicc::RigidBody ground(0.0f, glm::vec3(0.0f), 0.0f);
+			ground.setCollider(Physicc::BoxCollider(
+				glm::vec3(side * 0.5f - 2.0f, -0.5f, side * 0.5f - 2.0f),
+				glm::vec3(0.0f), glm::vec3(side, 1.0f, side)));
+			world.addRigidBody(ground);
+		} else
+		{
+			world.setGravity(glm::vec3(0.0f));
+		}
+
+		for (const auto& body : makeBodies(scene, count))
+		{
+			world.addRigidBody(body);
+		}
+	}
+}
+
+#endif //__SCENES_H__
@@ -0,0 +1,56 @@
+/**
+ * @file world_bench.cpp
+ * @brief Benchmarks of whole simulation steps.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* benchmark header */
+
+#include "tools/Tracy.hpp"
+
+#include "benchmark/benchmark.h"
+#include "physicsworld.hpp"
+#include "scenes.hpp"
+
+namespace PhysiccBench
+{
+	/**
+	 * @brief Steps a world filled with a scene
+	 *
+	 * The world is stepped a few times before timing starts, so that the
+	 * contact caches are warm and stacks have settled.
+	 */
+	void StepSimulation(benchmark::State& state)
+	{
+		constexpr int warmupSteps = 3;
+		constexpr float timestep = 1.0f / 60.0f;
+
+		auto scene = static_cast<Scene>(state.range(0));
+		Physicc::PhysicsWorld world(glm::vec3(0.0f));
+		populateWorld(world, scene, static_cast<std::size_t>(state.range(1)));
+
+		for (int i = 0; i < warmupSteps; i++)
+		{
+			world.stepSimulation(timestep);
+		}
+
+		for (auto _ : state)
+		{
+			world.stepSimulation(timestep);
+		}
+
+		state.SetItemsProcessed(state.iterations() * state.range(1));
+		state.counters["contacts"] =
+			static_cast<double>(world.getContacts().size());
+		state.SetLabel(getSceneName(scene));
+	}
+
+	BENCHMARK(StepSimulation)
+		->ArgNames({"scene", "bodies"})
+		->ArgsProduct({{e_uniform, e_clustered, e_stacked},
+		               {1000, 10000, 100000, 1000000}})
+		->Unit(benchmark::kMillisecond)
+		->UseRealTime();
+}
@@ -0,0 +1,169 @@
+#ifndef __AABBBATCH_H__
+#define __AABBBATCH_H__
+
+#include "boundingvolume.hpp"
+#include "simd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A growable array of AABBs, stored as a Structure of Arrays
+	 *
+	 * Each bound component lives in its own contiguous array, so one AABB
+	 * can be tested against `width` AABBs at once with SIMD instructions
+	 * (4 with SSE, 8 with AVX). The arrays are always padded to a multiple
+	 * of `width` with empty boxes (lower bound +inf, upper bound -inf),
+	 * which never overlap anything and don't affect enclosing volumes, so
+	 * the kernels never need a scalar tail loop.
+	 */
+	class AABBBatch
+	{
+		public:
+#ifdef PHYSICC_AVX
+			static constexpr std::size_t width = 8;
+#else
+			static constexpr std::size_t width = 4;
+#endif
+
+			[[nodiscard]] inline std::size_t size() const
+			{
+				return m_size;
+			}
+
+			[[nodiscard]] inline bool empty() const
+			{
+				return m_size == 0;
+			}
+
+			void clear();
+			void push_back(const BoundingVolume::AABB& volume);
+			void set(std::size_t index, const BoundingVolume::AABB& volume);
+			[[nodiscard]] BoundingVolume::AABB get(std::size_t index) const;
+
+			/**
+			 * @brief Removes the AABB at index by moving the last one into
+			 * its place, just like a swap and pop on a std::vector
+			 */
+			void swapRemove(std::size_t index);
+
+			/**
+			 * @brief Tests volume against the `width` AABBs starting at first
+			 *
+			 * @param first Index of the first AABB, a multiple of width
+			 * @return A mask with bit i set if AABB first + i overlaps volume
+			 */
+			[[nodiscard]] inline std::uint32_t overlapMask(
+				const BoundingVolume::AABB& volume, std::size_t first) const;
+
+			/**
+			 * @brief Calls callback(index) for every AABB that overlaps volume
+			 */
+			template <typename Callback>
+			void forEachOverlap(const BoundingVolume::AABB& volume,
+			                    Callback&& callback) const;
+
+			/**
+			 * @brief Returns the minimal AABB enclosing every AABB of the batch
+			 */
+			[[nodiscard]] BoundingVolume::AABB enclosingBV() const;
+
+			/**
+			 * @brief Computes the volume of every AABB of the batch
+			 *
+			 * @param volumes Output buffer, resized to size()
+			 */
+			void getVolumes(std::vector<float>& volumes) const;
+
+		private:
+			std::vector<float> m_minX, m_minY, m_minZ;
+			std::vector<float> m_maxX, m_maxY, m_maxZ;
+			std::size_t m_size = 0;
+
+			void setEmpty(std::size_t index);
+	};
+
+	inline std::uint32_t AABBBatch::overlapMask(
+		const BoundingVolume::AABB& volume, std::size_t first) const
+	{
+		glm::vec3 lower = volume.getLowerBound();
+		glm::vec3 upper = volume.getUpperBound();
+
+		//Same test as BoxBV::overlapsWith, for all lanes at once:
+		//batch.lower <= volume.upper && batch.upper >= volume.lower
+#if defined(PHYSICC_AVX)
+		__m256 minX = _mm256_loadu_ps(&m_minX[first]);
+		__m256 minY = _mm256_loadu_ps(&m_minY[first]);
+		__m256 minZ = _mm256_loadu_ps(&m_minZ[first]);
+		__m256 maxX = _mm256_loadu_ps(&m_maxX[first]);
+		__m256 maxY = _mm256_loadu_ps(&m_maxY[first]);
+		__m256 maxZ = _mm256_loadu_ps(&m_maxZ[first]);
+
+		__m256 result = _mm256_and_ps(
+			_mm256_cmp_ps(minX, _mm256_set1_ps(upper.x), _CMP_LE_OQ),
+			_mm256_cmp_ps(maxX, _mm256_set1_ps(lower.x), _CMP_GE_OQ));
+		result = _mm256_and_ps(result, _mm256_and_ps(
+			_mm256_cmp_ps(minY, _mm256_set1_ps(upper.y), _CMP_LE_OQ),
+			_mm256_cmp_ps(maxY, _mm256_set1_ps(lower.y), _CMP_GE_OQ)));
+		result = _mm256_and_ps(result, _mm256_and_ps(
+			_mm256_cmp_ps(minZ, _mm256_set1_ps(upper.z), _CMP_LE_OQ),
+			_mm256_cmp_ps(maxZ, _mm256_set1_ps(lower.z), _CMP_GE_OQ)));
+
+		return static_cast<std::uint32_t>(_mm256_movemask_ps(result));
+#elif defined(PHYSICC_SSE2)
+		__m128 result = _mm_and_ps(
+			_mm_cmple_ps(_mm_loadu_ps(&m_minX[first]), _mm_set1_ps(upper.x)),
+			_mm_cmpge_ps(_mm_loadu_ps(&m_maxX[first]), _mm_set1_ps(lower.x)));
+		result = _mm_and_ps(result, _mm_and_ps(
+			_mm_cmple_ps(_mm_loadu_ps(&m_minY[first]), _mm_set1_ps(upper.y)),
+			_mm_cmpge_ps(_mm_loadu_ps(&m_maxY[first]), _mm_set1_ps(lower.y))));
+		result = _mm_and_ps(result, _mm_and_ps(
+			_mm_cmple_ps(_mm_loadu_ps(&m_minZ[first]), _mm_set1_ps(upper.z)),
+			_mm_cmpge_ps(_mm_loadu_ps(&m_maxZ[first]), _mm_set1_ps(lower.z))));
+
+		return static_cast<std::uint32_t>(_mm_movemask_ps(result));
+#else
+		std::uint32_t mask = 0;
+
+		for (std::size_t i = 0; i < width; i++)
+		{
+			std::size_t j = first + i;
+			bool overlaps = (m_minX[j] <= upper.x) & (m_maxX[j] >= lower.x)
+				& (m_minY[j] <= upper.y) & (m_maxY[j] >= lower.y)
+				& (m_minZ[j] <= upper.z) & (m_maxZ[j] >= lower.z);
+
+			mask |= static_cast<std::uint32_t>(overlaps) << i;
+		}
+
+		return mask;
+#endif
+	}
+
+	template <typename Callback>
+	void AABBBatch::forEachOverlap(const BoundingVolume::AABB& volume,
+	                               Callback&& callback) const
+	{
+		for (std::size_t first = 0; first < m_size; first += width)
+		{
+			std::uint32_t mask = overlapMask(volume, first);
+
+			while (mask != 0)
+			{
+				std::size_t lane = 0;
+
+				while (!(mask & (1u << lane)))
+				{
+					lane++;
+				}
+
+				mask &= mask - 1;
+				//clears the lowest set bit
+				callback(first + lane);
+			}
+		}
+	}
+}
+
+#endif //__AABBBATCH_H__
@@ -0,0 +1,70 @@
+#ifndef __ALLOCATOR_H__
+#define __ALLOCATOR_H__
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief Allocator returning memory aligned to Alignment bytes
+	 *
+	 * Used for the arrays that SIMD loops run over, so that they start on a
+	 * cache line and aligned loads can be used on them.
+	 */
+	template <typename T, std::size_t Alignment = 64>
+	class AlignedAllocator
+	{
+		public:
+			static_assert(Alignment >= alignof(T),
+			              "Alignment must not be weaker than that of T");
+
+			using value_type = T;
+
+			template <typename U>
+			struct rebind
+			{
+				using other = AlignedAllocator<U, Alignment>;
+			};
+
+			AlignedAllocator() = default;
+
+			template <typename U>
+			AlignedAllocator(const AlignedAllocator<U, Alignment>&)
+			{
+			}
+
+			[[nodiscard]] T* allocate(std::size_t count)
+			{
+				void* memory = ::operator new(count * sizeof(T),
+				                              std::align_val_t(Alignment));
+
+				return static_cast<T*>(memory);
+			}
+
+			void deallocate(T* pointer, std::size_t)
+			{
+				::operator delete(pointer, std::align_val_t(Alignment));
+			}
+
+			template <typename U>
+			[[nodiscard]] inline bool
+			operator==(const AlignedAllocator<U, Alignment>&) const
+			{
+				return true;
+			}
+
+			template <typename U>
+			[[nodiscard]] inline bool
+			operator!=(const AlignedAllocator<U, Alignment>&) const
+			{
+				return false;
+			}
+	};
+
+	template <typename T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+}
+
+#endif //__ALLOCATOR_H__
@@ -0,0 +1,388 @@
+#ifndef __BODYSTORAGE_H__
+#define __BODYSTORAGE_H__
+
+#include "tools/Tracy.hpp"
+
+#include "glm/glm.hpp"
+#include "allocator.hpp"
+#include "ccd.hpp"
+#include "collider.hpp"
+#include "rigidbody.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A stable reference to a body in a BodyStorage
+	 *
+	 * The index names a slot, which keeps pointing at the same body no
+	 * matter how the body arrays get reordered. The generation is bumped
+	 * every time a slot is reused, so handles to removed bodies can be told
+	 * apart from handles to whatever body took their slot.
+	 */
+	struct BodyHandle
+	{
+		static constexpr std::uint32_t nullIndex = ~std::uint32_t(0);
+
+		std::uint32_t index = nullIndex;
+		std::uint32_t generation = 0;
+
+		[[nodiscard]] inline bool operator==(const BodyHandle& other) const
+		{
+			return index == other.index && generation == other.generation;
+		}
+
+		[[nodiscard]] inline bool operator!=(const BodyHandle& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	/**
+	 * @brief Refers to a collider in the pool of its shape
+	 */
+	struct ColliderHandle
+	{
+		Collider::Type type;
+		std::uint32_t index;
+	};
+
+	/**
+	 * @brief Structure of Arrays storage for rigid bodies
+	 *
+	 * Every property of the bodies lives in its own dense, aligned array, so
+	 * that the per-step loops (integration, AABB updates) walk contiguous
+	 * memory and vectorize. Removing a body moves the last one into its
+	 * place, which keeps the arrays dense but reorders them: dense indices
+	 * are only valid until the next removal, handles stay valid until the
+	 * body they refer to is removed.
+	 *
+	 * Colliders are large and only read by the broadphase and the narrow
+	 * phase, so they are kept out of the hot arrays. Each shape has a dense
+	 * pool of its own, which bodies refer to by handle. Like the body
+	 * arrays, each pool keeps the colliders of awake bodies at its front,
+	 * so loops over the colliders (like updateColliders) walk one shape's
+	 * awake colliders in order, with the shape's functions inlined.
+	 *
+	 * A body with a mass of 0 is static, and gets an inverse mass of 0.
+	 *
+	 * Awake bodies are kept at the front of the arrays, and sleeping bodies
+	 * after them, so the per-step loops only run over the first
+	 * getAwakeCount() bodies. Falling asleep and waking up move bodies
+	 * across that boundary, which reorders the arrays like a removal does.
+	 * The bodies of a sleeping island are linked together by slot, so that
+	 * waking any of them wakes the whole island.
+	 */
+	class BodyStorage
+	{
+		public:
+			BodyHandle add(const RigidBody& body);
+			void remove(BodyHandle handle);
+			void clear();
+
+			/**
+			 * @brief Allocates room for a number of bodies up front, so that
+			 * adding up to that many bodies with colliders of one shape
+			 * doesn't allocate
+			 */
+			void reserve(std::size_t count,
+			             Collider::Type shape = Collider::e_box);
+
+			/**
+			 * @brief Moves the colliders of the awake bodies to their
+			 * positions, and computes their AABBs
+			 *
+			 * Only the awake bodies are visited, so sleeping bodies cost
+			 * nothing here.
+			 *
+			 * @param volumes Resized to getAwakeCount(), and filled with the
+			 * AABBs by dense index
+			 */
+			void updateColliders(AlignedVector<BoundingVolume::AABB>& volumes);
+
+			[[nodiscard]] bool contains(BodyHandle handle) const;
+
+			[[nodiscard]] inline std::size_t getAwakeCount() const
+			{
+				return m_awakeCount;
+			}
+
+			[[nodiscard]] inline bool isAwake(std::size_t index) const
+			{
+				return index < m_awakeCount;
+			}
+
+			/**
+			 * @brief Puts a set of bodies to sleep, as one island
+			 *
+			 * Their velocities and forces are cleared. Waking any of them
+			 * later wakes all of them.
+			 *
+			 * @param slots Slots of awake bodies
+			 */
+			void sleep(const std::uint32_t* slots, std::size_t count);
+
+			/**
+			 * @brief Wakes the island of the body in a slot, if it sleeps
+			 */
+			void wake(std::uint32_t slot);
+
+			[[nodiscard]] inline std::size_t size() const
+			{
+				return m_slotOf.size();
+			}
+
+			[[nodiscard]] inline bool empty() const
+			{
+				return m_slotOf.empty();
+			}
+
+			/**
+			 * @brief Returns the dense index of a body, valid until the next
+			 * removal, or until bodies fall asleep or wake up
+			 */
+			[[nodiscard]] inline std::size_t getIndex(BodyHandle handle) const
+			{
+				return m_slots[handle.index].dense;
+			}
+
+			[[nodiscard]] inline std::size_t
+			getIndexOfSlot(std::uint32_t slot) const
+			{
+				return m_slots[slot].dense;
+			}
+
+			[[nodiscard]] inline BodyHandle getHandle(std::size_t index) const
+			{
+				std::uint32_t slot = m_slotOf[index];
+
+				return {slot, m_slots[slot].generation};
+			}
+
+			/**
+			 * @brief Returns the slot of the body at a dense index
+			 *
+			 * Slots are small, stable integers, which is what bodies are
+			 * identified with in the broadphase.
+			 */
+			[[nodiscard]] inline std::uint32_t getSlot(std::size_t index) const
+			{
+				return m_slotOf[index];
+			}
+
+			[[nodiscard]] inline std::size_t getSlotCount() const
+			{
+				return m_slots.size();
+			}
+
+			[[nodiscard]] inline AlignedVector<glm::vec3>& getPositions()
+			{
+				return m_positions;
+			}
+
+			[[nodiscard]] inline const AlignedVector<glm::vec3>&
+			getPositions() const
+			{
+				return m_positions;
+			}
+
+			/**
+			 * @brief Positions of the bodies before the last step, for
+			 * interpolating between steps
+			 */
+			[[nodiscard]] inline AlignedVector<glm::vec3>&
+			getPreviousPositions()
+			{
+				return m_previousPositions;
+			}
+
+			[[nodiscard]] inline const AlignedVector<glm::vec3>&
+			getPreviousPositions() const
+			{
+				return m_previousPositions;
+			}
+
+			[[nodiscard]] inline AlignedVector<glm::vec3>& getVelocities()
+			{
+				return m_velocities;
+			}
+
+			[[nodiscard]] inline const AlignedVector<glm::vec3>&
+			getVelocities() const
+			{
+				return m_velocities;
+			}
+
+			[[nodiscard]] inline AlignedVector<glm::vec3>& getForces()
+			{
+				return m_forces;
+			}
+
+			[[nodiscard]] inline const AlignedVector<glm::vec3>&
+			getForces() const
+			{
+				return m_forces;
+			}
+
+			[[nodiscard]] inline AlignedVector<float>& getInverseMasses()
+			{
+				return m_inverseMasses;
+			}
+
+			[[nodiscard]] inline const AlignedVector<float>&
+			getInverseMasses() const
+			{
+				return m_inverseMasses;
+			}
+
+			[[nodiscard]] inline AlignedVector<float>& getGravityScales()
+			{
+				return m_gravityScales;
+			}
+
+			[[nodiscard]] inline const AlignedVector<float>&
+			getGravityScales() const
+			{
+				return m_gravityScales;
+			}
+
+			/**
+			 * @brief How long each body has been slower than the sleep
+			 * threshold
+			 */
+			[[nodiscard]] inline AlignedVector<float>& getSleepTimes()
+			{
+				return m_sleepTimes;
+			}
+
+			[[nodiscard]] inline const AlignedVector<float>&
+			getSleepTimes() const
+			{
+				return m_sleepTimes;
+			}
+
+			[[nodiscard]] inline const AlignedVector<float>&
+			getFrictions() const
+			{
+				return m_frictions;
+			}
+
+			[[nodiscard]] inline const AlignedVector<float>&
+			getRestitutions() const
+			{
+				return m_restitutions;
+			}
+
+			/**
+			 * @brief Radius of the sphere swept for each body by continuous
+			 * collision detection, or 0 for bodies without it
+			 */
+			[[nodiscard]] inline const AlignedVector<float>& getCCDRadii() const
+			{
+				return m_ccdRadii;
+			}
+
+			[[nodiscard]] inline const AlignedVector<ColliderHandle>&
+			getColliderHandles() const
+			{
+				return m_colliders;
+			}
+
+			[[nodiscard]] inline const Collider&
+			getCollider(std::size_t index) const
+			{
+				ColliderHandle handle = m_colliders[index];
+
+				switch (handle.type)
+				{
+					case Collider::e_box:
+						return m_boxes.colliders[handle.index];
+					case Collider::e_sphere:
+						return m_spheres.colliders[handle.index];
+					case Collider::e_capsule:
+						return m_capsules.colliders[handle.index];
+					default:
+						return m_hulls.colliders[handle.index];
+				}
+			}
+
+			[[nodiscard]] inline Collider& getCollider(std::size_t index)
+			{
+				return const_cast<Collider&>(
+					static_cast<const BodyStorage&>(*this).getCollider(index));
+			}
+
+			/**
+			 * @brief Rebuilds a RigidBody from the stored properties of the
+			 * body at a dense index
+			 */
+			[[nodiscard]] RigidBody getRigidBody(std::size_t index) const;
+
+		private:
+			/**
+			 * @brief The colliders of one shape, those of awake bodies first
+			 */
+			template <typename Shape>
+			struct ColliderPool
+			{
+				std::vector<Shape> colliders;
+				std::vector<std::uint32_t> bodies;
+				//dense index of the body of each collider
+				std::size_t awakeCount = 0;
+			};
+
+			void swapBodies(std::size_t first, std::size_t second);
+
+			template <typename Function>
+			void visitPool(Collider::Type type, Function&& function);
+
+			template <typename Shape>
+			std::uint32_t addCollider(ColliderPool<Shape>& pool,
+			                          const Shape& collider,
+			                          std::uint32_t body);
+			template <typename Shape>
+			void swapColliders(ColliderPool<Shape>& pool, std::size_t first,
+			                   std::size_t second);
+			void setColliderAwake(std::size_t index, bool awake);
+			void setColliderBody(std::size_t index);
+			template <typename Shape>
+			void updatePool(ColliderPool<Shape>& pool,
+			                BoundingVolume::AABB* volumes);
+
+			struct Slot
+			{
+				std::uint32_t dense;
+				std::uint32_t generation;
+				//for free slots, dense is the next free slot instead
+				std::uint32_t nextAsleep;
+				//next slot of the same sleeping island, in a circular list
+			};
+
+			AlignedVector<glm::vec3> m_positions;
+			AlignedVector<glm::vec3> m_previousPositions;
+			AlignedVector<glm::vec3> m_velocities;
+			AlignedVector<glm::vec3> m_forces;
+			AlignedVector<float> m_inverseMasses;
+			AlignedVector<float> m_gravityScales;
+			AlignedVector<float> m_frictions;
+			AlignedVector<float> m_restitutions;
+			AlignedVector<float> m_sleepTimes;
+			AlignedVector<float> m_ccdRadii;
+			AlignedVector<ColliderHandle> m_colliders;
+			AlignedVector<std::uint32_t> m_slotOf;
+			//all indexed by dense index
+
+			std::vector<Slot> m_slots;
+			std::uint32_t m_freeSlot = BodyHandle::nullIndex;
+			std::size_t m_awakeCount = 0;
+
+			ColliderPool<BoxCollider> m_boxes;
+			ColliderPool<SphereCollider> m_spheres;
+			ColliderPool<CapsuleCollider> m_capsules;
+			ColliderPool<ConvexHullCollider> m_hulls;
+	};
+}
+
+#endif //__BODYSTORAGE_H__
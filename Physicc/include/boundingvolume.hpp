@@ -61,15 +61,11 @@ namespace Physicc
 				 */
 				BaseBV(const BoundingObject& volume)
 				{
-					ZoneScoped;
-
 					typeCast()->setVolume(volume);
 				}
 
 				BaseBV(const glm::vec3& lowerBound, const glm::vec3& upperBound)
 				{
-					ZoneScoped;
-
 					typeCast()->setVolume(lowerBound, upperBound);
 				}
 
@@ -82,8 +78,6 @@ namespace Physicc
  				 */
 				[[nodiscard]] inline bool overlapsWith(const BaseBV& bv) const
 				{
-					ZoneScoped;
-
 					return constTypeCast()->overlapsWith(static_cast<const Derived&>(bv));
 				}
 				//implicit contract: all child classes of BaseBV must have this
@@ -91,8 +85,6 @@ namespace Physicc
 
 				[[nodiscard]] inline float getVolume() const
 				{
-					ZoneScoped;
-
 					return constTypeCast()->getVolume();
 				}
 				//Since template instantiations are lazy, a (child) class that
@@ -101,10 +93,13 @@ namespace Physicc
 				//to use this function will likely result in 5 pages of opaque
 				//errors.
 
-				[[nodiscard]] Derived enclosingBV(const BaseBV& bv) const
+				[[nodiscard]] inline float getSurfaceArea() const
 				{
-					ZoneScoped;
+					return constTypeCast()->getSurfaceArea();
+				}
 
+				[[nodiscard]] Derived enclosingBV(const BaseBV& bv) const
+				{
 					return constTypeCast()->enclosingBV(static_cast<const Derived&>(bv));
 				}
 
@@ -154,23 +149,17 @@ namespace Physicc
 
 				BoxBV(const glm::vec3& lowerBound, const glm::vec3& upperBound)
 				{
-					ZoneScoped;
-
 					this->m_volume = {lowerBound, upperBound};
 				}
 
 				inline void setVolume(const T& volume)
 				{
-					ZoneScoped;
-
 					this->m_volume = volume;
 				}
 
 				inline void setVolume(const glm::vec3& lowerBound,
 				                      const glm::vec3& upperBound)
 				{
-					ZoneScoped;
-
 					this->m_volume = {lowerBound, upperBound};
 					//implicit contract: any BoxBV will have a struct that has
 					//lowerBound and upperBound `glm::vec3`s.
@@ -178,8 +167,6 @@ namespace Physicc
 
 				inline float getVolume() const
 				{
-					ZoneScoped;
-
 					//[[nodiscard]] is not needed here because this function is
 					//never called by the end user. It is simply called by BV
 					//itself, which doesn't actually discard the return type, so
@@ -189,10 +176,17 @@ namespace Physicc
 						* (this->m_volume.upperBound.z - this->m_volume.lowerBound.z);
 				}
 
-				inline bool overlapsWith(const BoxBV& bv) const
+				inline float getSurfaceArea() const
 				{
-					ZoneScoped;
+					glm::vec3 d = this->m_volume.upperBound
+						- this->m_volume.lowerBound;
+
+					return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+				}
+				//Used as the cost metric by the SAH builder
 
+				inline bool overlapsWith(const BoxBV& bv) const
+				{
 					return (this->m_volume.lowerBound.x <= bv.m_volume.upperBound.x
 							&& this->m_volume.upperBound.x >= bv.m_volume.lowerBound.x)
 						&& (this->m_volume.lowerBound.y <= bv.m_volume.upperBound.y
@@ -203,13 +197,46 @@ namespace Physicc
 
 				inline BoxBV enclosingBV(const BoxBV& bv) const
 				{
-					ZoneScoped;
-
 					return {glm::min(this->m_volume.lowerBound, bv.m_volume.lowerBound),
 						glm::max(this->m_volume.upperBound, bv.m_volume.upperBound)};
 				}
 				//As per our previous implicit contract, these `glm::vec3`s are
 				//guaranteed to exist, so this is legal.
+
+				[[nodiscard]] inline glm::vec3 getLowerBound() const
+				{
+					return this->m_volume.lowerBound;
+				}
+
+				[[nodiscard]] inline glm::vec3 getUpperBound() const
+				{
+					return this->m_volume.upperBound;
+				}
+
+				/**
+				 * @brief Returns whether bv lies completely inside this box
+				 */
+				[[nodiscard]] inline bool contains(const BoxBV& bv) const
+				{
+					const auto& volume = this->m_volume;
+
+					const auto& other = bv.m_volume;
+
+					return glm::all(glm::lessThanEqual(volume.lowerBound,
+					                                   other.lowerBound))
+						&& glm::all(glm::greaterThanEqual(volume.upperBound,
+						                                  other.upperBound));
+				}
+
+				/**
+				 * @brief Returns a copy of this box grown by margin on every
+				 * side
+				 */
+				[[nodiscard]] inline BoxBV fattened(float margin) const
+				{
+					return {this->m_volume.lowerBound - margin,
+						this->m_volume.upperBound + margin};
+				}
 		};
 	}
 
@@ -221,8 +248,6 @@ namespace Physicc
 		auto inline enclosingBV(const BVImpl::BaseBV<Derived, BoundingObject>& volume1,
 								const BVImpl::BaseBV<Derived, BoundingObject>& volume2)
 		{
-			ZoneScoped;
-
 			return volume1.enclosingBV(volume2);
 		}
 		//returns the minimal bounding volume that encompasses both of them
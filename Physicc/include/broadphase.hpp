@@ -0,0 +1,90 @@
+#ifndef __BROADPHASE_H__
+#define __BROADPHASE_H__
+
+#include "tools/Tracy.hpp"
+
+#include "boundingvolume.hpp"
+#include "profiling.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A pair of bodies whose bounding volumes (may) overlap
+	 *
+	 * Bodies are identified by the index they were inserted with, and
+	 * `first` is always smaller than `second`.
+	 */
+	struct CollisionPair
+	{
+		std::size_t first;
+		std::size_t second;
+
+		[[nodiscard]] inline bool operator==(const CollisionPair& other) const
+		{
+			return first == other.first && second == other.second;
+		}
+
+		[[nodiscard]] inline bool operator<(const CollisionPair& other) const
+		{
+			return first < other.first
+				|| (first == other.first && second < other.second);
+		}
+	};
+
+	/**
+	 * @brief Broadphase class
+	 *
+	 * This is a virtual class which acts as the base for all the algorithms
+	 * that find potentially colliding pairs of bodies, so that they can be
+	 * swapped per scene.
+	 */
+	class Broadphase
+	{
+		public:
+			enum Type
+			{
+				e_dynamicTree = 0,
+				e_sweepAndPrune = 1,
+				e_spatialHash = 2,
+				e_typecount = 3
+			};
+
+			virtual ~Broadphase() = default;
+
+			/**
+			 * @brief Creates a broadphase of the given type
+			 */
+			static std::unique_ptr<Broadphase> create(Type type);
+
+			[[nodiscard]] virtual Type getType() const = 0;
+
+			/**
+			 * @brief Starts tracking a body
+			 *
+			 * @param body An identifier for the body, which is what pairs are
+			 * reported with. Identifiers should be small and dense, like
+			 * indices into an array of bodies.
+			 * @param volume The current AABB of the body
+			 */
+			virtual void insert(std::size_t body,
+			                    const BoundingVolume::AABB& volume) = 0;
+
+			virtual void remove(std::size_t body) = 0;
+
+			virtual void update(std::size_t body,
+			                    const BoundingVolume::AABB& volume) = 0;
+
+			/**
+			 * @brief Finds every pair of bodies that may be colliding
+			 *
+			 * @param pairs Output buffer. It is cleared first, but its
+			 * capacity is reused, so steady-state frames don't allocate.
+			 */
+			virtual void findPairs(std::vector<CollisionPair>& pairs) = 0;
+	};
+}
+
+#endif //__BROADPHASE_H__
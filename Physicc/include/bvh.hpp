@@ -1,39 +1,302 @@
 #ifndef __BVH_H__
 #define __BVH_H__
 
+#include "tools/Tracy.hpp"
+
 #include "boundingvolume.hpp"
+#include "broadphase.hpp"
+#include "raycast.hpp"
 #include "rigidbody.hpp"
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace Physicc
 {
+	/**
+	 * @brief A single node of the flattened BVH
+	 *
+	 * Nodes are stored in depth-first order in one contiguous array, so the
+	 * left child of an internal node is always the node right after it, and
+	 * only the index of the right child has to be stored. Leaves hold the
+	 * index of their body in the (reordered) rigid body list instead.
+	 */
 	struct BVHNode
 	{
+		static constexpr std::uint32_t nullIndex = ~std::uint32_t(0);
+
 		BoundingVolume::AABB volume;
-		RigidBody* body = nullptr;
+		std::uint32_t body = nullIndex;
+		std::uint32_t right = nullIndex;
 
-		BVHNode* parent = nullptr;
-		BVHNode* left = nullptr;
-		BVHNode* right = nullptr;
+		[[nodiscard]] inline bool isLeaf() const
+		{
+			return body != nullIndex;
+		}
 	};
 
+	static_assert(sizeof(BVHNode) == 32,
+	              "BVHNode should fit in half a cache line");
+
 	class BVH
 	{
 		public:
-			BVH(std::vector<RigidBody> rigidBodyList);
+			/**
+			 * @brief Strategy used to split a set of bodies into two children
+			 *
+			 * e_median cuts at the median centroid of the widest axis, while
+			 * e_binnedSAH bins the centroids along every axis and picks the
+			 * split with the lowest Surface Area Heuristic cost.
+			 *
+			 * e_lbvh (linear BVH) sorts the bodies along a Morton (Z-order)
+			 * curve through their centroids, and splits every range where
+			 * the codes of its bodies first differ. It never looks at the
+			 * volumes while splitting, so it builds much faster than the
+			 * others but makes worse trees, which treelet restructuring
+			 * makes up for in part. Meant for large sets of static bodies.
+			 */
+			enum Builder
+			{
+				e_median = 0,
+				e_binnedSAH = 1,
+				e_lbvh = 2
+			};
+
+			/**
+			 * @brief Stacks the queries walk the tree with
+			 *
+			 * Queries only read the tree, and keep their own state in a
+			 * scratch, so any number of threads may query the same BVH at
+			 * once, each with a scratch of its own. Reusing a scratch
+			 * across queries saves reallocating its stacks, and the
+			 * overloads that don't take one allocate them on every call.
+			 */
+			struct QueryScratch
+			{
+				std::vector<std::uint32_t> stack;
+				std::vector<std::pair<std::uint32_t, std::uint32_t>> pairStack;
+				std::vector<std::pair<std::uint32_t, float>> rayStack;
+			};
+
+			BVH(std::vector<RigidBody> rigidBodyList,
+			    Builder builder = e_median,
+			    float rebuildThreshold = 1.5f);
+
+			inline void setBuilder(Builder builder)
+			{
+				m_builder = builder;
+			}
+
+			[[nodiscard]] inline Builder getBuilder() const
+			{
+				return m_builder;
+			}
+
+			inline void setRebuildThreshold(float rebuildThreshold)
+			{
+				m_rebuildThreshold = rebuildThreshold;
+			}
+
+			[[nodiscard]] inline float getRebuildThreshold() const
+			{
+				return m_rebuildThreshold;
+			}
+
+			/**
+			 * @brief Sets whether builds end with a treelet restructuring
+			 * pass
+			 *
+			 * Bottom up, every node and up to 7 of its descendants (a
+			 * treelet) get the topology that minimizes their cost, found
+			 * by trying every way of splitting the treelet. This mostly
+			 * pays off after an e_lbvh build, at a cost several times that
+			 * of the build itself. Default = false
+			 */
+			inline void setTreeletRestructuring(bool restructure)
+			{
+				m_restructure = restructure;
+			}
 
-			inline void buildTree();
+			[[nodiscard]] inline bool getTreeletRestructuring() const
+			{
+				return m_restructure;
+			}
+
+			void buildTree();
 			//build a tree of the bounding volumes
 
-			//convert the tree into a linear data structure
-			std::vector<RigidBody>& convert();
+			void refit();
+			//recompute the bounding volumes of the existing tree
+
+			/**
+			 * @brief Refits the tree, and rebuilds it if it has degraded too
+			 * much
+			 *
+			 * @return true if the tree was rebuilt, false if it was only refit
+			 */
+			bool update();
+
+			/**
+			 * @brief Current cost of the tree relative to when it was built
+			 *
+			 * The cost is the sum of the surface areas of the internal nodes,
+			 * which is what the number of overlap tests during a query
+			 * scales with. A freshly built tree has a quality of 1, and
+			 * bodies moving away from their original neighbours make it grow.
+			 */
+			[[nodiscard]] inline float getQuality() const
+			{
+				return m_buildCost > 0.0f ? m_cost / m_buildCost : 1.0f;
+			}
+
+			//returns the tree as a depth-first ordered linear array
+			[[nodiscard]] inline const std::vector<BVHNode>& convert() const
+			{
+				return m_nodes;
+			}
+
+			[[nodiscard]] inline const std::vector<RigidBody>&
+			getRigidBodyList() const
+			{
+				return m_rigidBodyList;
+			}
+
+			//Bodies may be moved through this, as long as refit() or
+			//update() is called before the tree is queried again. The list
+			//itself can't be resized or reordered, since the leaves index it
+			[[nodiscard]] inline RigidBody& getRigidBody(std::size_t index)
+			{
+				return m_rigidBodyList[index];
+			}
+
+			/**
+			 * @brief Finds every body whose AABB overlaps volume
+			 *
+			 * @param volume The AABB to test against
+			 * @param out Output iterator which receives the index (in
+			 * getRigidBodyList()) of every overlapping body
+			 * @return The output iterator past the last written index
+			 */
+			template <typename OutputIt>
+			OutputIt queryOverlaps(const BoundingVolume::AABB& volume,
+			                       OutputIt out, QueryScratch& scratch) const;
+
+			template <typename OutputIt>
+			inline OutputIt queryOverlaps(const BoundingVolume::AABB& volume,
+			                              OutputIt out) const
+			{
+				QueryScratch scratch;
+
+				return queryOverlaps(volume, out, scratch);
+			}
+
+			/**
+			 * @brief Finds every pair of bodies whose AABBs overlap
+			 *
+			 * Walks the tree against itself, descending into both subtrees
+			 * at once with an explicit stack of node pairs.
+			 *
+			 * @param pairs Output buffer of indices into getRigidBodyList().
+			 * It is cleared first, but its capacity is reused, so
+			 * steady-state frames don't allocate (given the same scratch).
+			 */
+			void findPairs(std::vector<CollisionPair>& pairs,
+			               QueryScratch& scratch) const;
+
+			inline void findPairs(std::vector<CollisionPair>& pairs) const
+			{
+				QueryScratch scratch;
+				findPairs(pairs, scratch);
+			}
+
+			/**
+			 * @brief Finds the closest body hit by a ray
+			 *
+			 * Children are visited front to back, and subtrees starting
+			 * further away than the closest hit so far are skipped.
+			 * Candidates are tested against the exact collider shapes.
+			 *
+			 * @param origin Origin of the ray
+			 * @param direction Direction of the ray (not necessarily unit)
+			 * @param maxT Length of the ray, in multiples of direction
+			 * @return The closest hit, with the index of the body in
+			 * getRigidBodyList(), if there is one
+			 */
+			[[nodiscard]] std::optional<RaycastHit>
+			raycast(const glm::vec3& origin, const glm::vec3& direction,
+			        float maxT, QueryScratch& scratch) const;
+
+			[[nodiscard]] inline std::optional<RaycastHit>
+			raycast(const glm::vec3& origin, const glm::vec3& direction,
+			        float maxT) const
+			{
+				QueryScratch scratch;
+
+				return raycast(origin, direction, maxT, scratch);
+			}
+
+			/**
+			 * @brief Casts many rays at once
+			 *
+			 * Rays are traversed in packets, so every node fetched from
+			 * memory is tested against all the rays of a packet. This pays
+			 * off when neighbouring rays are coherent (similar origins and
+			 * directions), as for picking or shooting through a frustum.
+			 *
+			 * @param hits Output buffer, resized to rays.size(), so that
+			 * hits[i] is the closest hit of rays[i]
+			 */
+			void raycast(const std::vector<Ray>& rays,
+			             std::vector<std::optional<RaycastHit>>& hits,
+			             QueryScratch& scratch) const;
+
+			inline void raycast(
+				const std::vector<Ray>& rays,
+				std::vector<std::optional<RaycastHit>>& hits) const
+			{
+				QueryScratch scratch;
+				raycast(rays, hits, scratch);
+			}
 
 		private:
-			BVHNode* m_head;
+			/**
+			 * @brief The bounds of a body, fetched once per build
+			 *
+			 * The builders sort and partition these small records rather
+			 * than the bodies, and never go through the colliders while
+			 * splitting. The bodies are put in the final order once, at
+			 * the end of the build.
+			 */
+			struct Primitive
+			{
+				BoundingVolume::AABB volume;
+				glm::vec3 centroid;
+				std::uint32_t body;
+				//index in m_rigidBodyList before the build
+			};
+
+			std::vector<BVHNode> m_nodes;
 			std::vector<RigidBody> m_rigidBodyList;
+			std::vector<Primitive> m_primitives;
+			std::vector<RigidBody> m_reorderedBodies;
+			//scratch list the bodies are reordered into
+			Builder m_builder;
+			float m_rebuildThreshold;
+			bool m_restructure = false;
+			float m_buildCost = 0.0f;
+			float m_cost = 0.0f;
 
-			BoundingVolume::AABB computeBV(std::size_t start, std::size_t end);
+			BoundingVolume::AABB computeBV(std::size_t start,
+			                               std::size_t end) const;
+			BVImpl::AABB computeCentroidBounds(std::size_t start,
+			                                   std::size_t end) const;
+			float computeCost() const;
 
-			void buildTree(BVHNode* node, std::size_t start, std::size_t end);
+			void buildTree(std::size_t index, std::size_t start,
+			               std::size_t end, unsigned int taskDepth);
+			//Subtrees bigger than a threshold are built as parallel tasks,
+			//as long as taskDepth allows spawning more of them
 
 			enum Axis {
 				X,
@@ -43,7 +306,99 @@ namespace Physicc
 
 			void sort(Axis axis, std::size_t start, std::size_t end);
 			Axis getMedianCuttingAxis(std::size_t start, std::size_t end);
+
+			std::size_t splitMedian(std::size_t start, std::size_t end);
+			std::size_t splitBinnedSAH(std::size_t start, std::size_t end);
+			//Both reorder [start, end) of m_primitives and return the index
+			//of the first primitive that goes into the right child
+
+			struct MortonKey
+			{
+				std::uint64_t code;
+				std::uint32_t primitive;
+			};
+
+			std::vector<MortonKey> m_mortonKeys;
+			std::vector<MortonKey> m_mortonScratch;
+			std::vector<Primitive> m_sortedPrimitives;
+			//scratch list the primitives are reordered into
+
+			void buildMorton(unsigned int taskDepth);
+			void buildMorton(std::size_t index, std::size_t start,
+			                 std::size_t end, unsigned int taskDepth);
+			std::size_t splitMorton(std::size_t start, std::size_t end) const;
+			//Returns the index of the first primitive whose code has the
+			//highest differing bit of [start, end) set
+
+			/**
+			 * @brief The topology of a node during treelet restructuring,
+			 * which no longer follows the depth-first layout
+			 */
+			struct TreeletNode
+			{
+				std::uint32_t left;
+				std::uint32_t right;
+				//BVHNode::nullIndex for leaves
+				std::uint32_t leafCount;
+				float cost;
+				//sum of the surface areas of the internal nodes of the subtree
+			};
+
+			std::vector<TreeletNode> m_treeletNodes;
+			std::vector<BVHNode> m_flatNodes;
+			//scratch list the restructured nodes are laid out into
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> m_pairStack;
+			//(node, its place in m_flatNodes) still to be laid out
+
+			void restructure(unsigned int taskDepth);
+			void restructure(std::size_t index, std::size_t end,
+			                 unsigned int taskDepth);
+			void initTreeletNode(std::size_t index);
+			void optimizeTreelet(std::size_t index);
+			void flatten();
 	};
+
+	template <typename OutputIt>
+	OutputIt BVH::queryOverlaps(const BoundingVolume::AABB& volume,
+	                            OutputIt out, QueryScratch& scratch) const
+	{
+		PhysiccZoneFine;
+
+		if (m_nodes.empty())
+		{
+			return out;
+		}
+
+		auto& stack = scratch.stack;
+		stack.clear();
+		stack.push_back(0);
+
+		while (!stack.empty())
+		{
+			std::uint32_t index = stack.back();
+			stack.pop_back();
+
+			const auto& node = m_nodes[index];
+
+			if (!node.volume.overlapsWith(volume))
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				*out++ = static_cast<std::size_t>(node.body);
+			} else
+			{
+				stack.push_back(node.right);
+				stack.push_back(index + 1);
+				//the left child is popped first, so the walk stays in
+				//depth-first (i.e. memory) order
+			}
+		}
+
+		return out;
+	}
 }
 
 #endif //__BVH_H__
@@ -0,0 +1,62 @@
+#ifndef __CCD_H__
+#define __CCD_H__
+
+#include "tools/Tracy.hpp"
+
+#include "glm/glm.hpp"
+#include "collider.hpp"
+
+namespace Physicc
+{
+	/**
+	 * @brief The first contact of a moving sphere with a collider
+	 */
+	struct TimeOfImpact
+	{
+		float t;
+		//fraction of the displacement travelled before the contact
+		glm::vec3 point;
+		glm::vec3 normal;
+		//unit vector from the collider to the sphere, at the contact
+	};
+
+	/**
+	 * @brief Returns the radius of the sphere swept for a collider during
+	 * continuous collision detection
+	 *
+	 * The sphere is centered on the collider's position and lies inside
+	 * its shape, so if the sphere doesn't pass through anything, neither
+	 * does the core of the collider. For hulls it only follows the
+	 * extents along the local axes, which is exact for boxes and close for
+	 * most other hulls.
+	 *
+	 * Never returns less than a small positive minimum, even for flat
+	 * colliders or hulls that don't contain their position, since a
+	 * radius of 0 means a body doesn't use CCD.
+	 */
+	[[nodiscard]] float getSweptSphereRadius(const Collider& collider);
+
+	/**
+	 * @brief Finds when a sphere moving along a straight line first comes
+	 * into contact with a collider (its time of impact)
+	 *
+	 * Runs conservative advancement: the distance between the sphere and
+	 * the collider, divided by how fast the sphere approaches the plane
+	 * separating them, is a step the sphere can take without reaching the
+	 * collider. Steps are taken until the gap closes, or the sphere gets
+	 * to the end of its displacement.
+	 *
+	 * Spheres that start out intersecting the collider aren't reported,
+	 * since the discrete contacts already take care of them.
+	 *
+	 * @param displacement Motion of the sphere relative to the collider
+	 * over the step
+	 * @return true if the sphere touches the collider within the
+	 * displacement
+	 */
+	bool sweepSphere(const glm::vec3& center, float radius,
+	                 const glm::vec3& displacement, const Collider& target,
+	                 TimeOfImpact& result);
+}
+
+#endif //__CCD_H__
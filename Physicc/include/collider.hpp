@@ -6,6 +6,9 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "boundingvolume.hpp"
+#include "profiling.hpp"
+#include "raycast.hpp"
+#include <type_traits>
 #include <vector>
 
 namespace Physicc
@@ -13,24 +16,29 @@ namespace Physicc
 	/**
 	 * @brief Collider class
 	 *  
-	 * This is a virtual class which acts as the base for all the shape specific classes
+	 * This is the base for all the shape specific classes. It has no
+	 * virtual functions: the shape is dispatched on getType(), so that
+	 * every collider is trivially copyable, and copying a body doesn't
+	 * allocate. A Collider can't be made or copied on its own, only as part
+	 * of a shape class, which keeps copies of it from being sliced. Use a
+	 * ColliderShape to hold a collider of any shape by value.
+	 *
+	 * The rotation matrix and the AABB relative to the position are
+	 * cached, and recomputed by the setters that change them (rotation,
+	 * scale and shape), so moving a collider costs nothing and the getters
+	 * only ever read. A const collider may be read from any number of
+	 * threads at once.
 	 */
 	class Collider
 	{
 		public:
-			Collider(glm::vec3 position = glm::vec3(0),
-			         glm::vec3 rotation = glm::vec3(0),
-			         glm::vec3 scale = glm::vec3(1));
-
 			/**
 	 		 * @brief Get Position of object's center
 	 		 *
 	 		 * @return glm::vec3
 	 		 */
-			[[nodiscard]] inline glm::vec3 getPosition()
+			[[nodiscard]] inline glm::vec3 getPosition() const
 			{
-				ZoneScoped;
-
 				return m_position;
 			}
 
@@ -39,10 +47,8 @@ namespace Physicc
 			 *
 			 * @return glm::vec3
 			 */
-			[[nodiscard]] inline glm::vec3 getRotate()
+			[[nodiscard]] inline glm::vec3 getRotate() const
 			{
-				ZoneScoped;
-
 				return m_rotate;
 			}
 
@@ -51,10 +57,8 @@ namespace Physicc
 			 *
 			 * @return glm::vec3
 			 */
-			[[nodiscard]] inline glm::vec3 getScale()
+			[[nodiscard]] inline glm::vec3 getScale() const
 			{
-				ZoneScoped;
-
 				return m_scale;
 			}
 
@@ -63,11 +67,17 @@ namespace Physicc
 			 *
 			 * @return glm::mat4
 			 */
-			[[nodiscard]] inline glm::mat4 getTransform()
+			[[nodiscard]] inline glm::mat4 getTransform() const
 			{
-				ZoneScoped;
+				//scaling in the local frame, then rotating, then moving to
+				//the position
+				glm::mat4 transform(m_rotation);
+				transform[0] *= m_scale.x;
+				transform[1] *= m_scale.y;
+				transform[2] *= m_scale.z;
+				transform[3] = glm::vec4(m_position, 1.0f);
 
-				return m_transform;
+				return transform;
 			}
 
 			/**
@@ -77,8 +87,6 @@ namespace Physicc
 			 */
 			inline void setPosition(glm::vec3 position)
 			{
-				ZoneScoped;
-
 				m_position = position;
 			}
 
@@ -89,9 +97,8 @@ namespace Physicc
 			 */
 			inline void setRotate(glm::vec3 rotate)
 			{
-				ZoneScoped;
-
 				m_rotate = rotate;
+				computeShape();
 			}
 
 			/**
@@ -101,37 +108,90 @@ namespace Physicc
 			 */
 			inline void setScale(glm::vec3 scale)
 			{
-				ZoneScoped;
-
 				m_scale = scale;
+				computeShape();
 			}
 
-			void updateTransform();
+			[[nodiscard]] inline BoundingVolume::AABB getAABB() const
+			{
+				return {m_position + m_localBounds.lowerBound,
+				        m_position + m_localBounds.upperBound};
+			}
 
-			virtual BoundingVolume::AABB getAABB() const = 0;
-			//Each child will calculate its AABB according to its own shape
+			[[nodiscard]] glm::vec3 getCentroid() const;
 
-			virtual glm::vec3 getCentroid() const = 0;
+			/**
+			 * @brief Casts a ray against the exact shape of the collider
+			 *
+			 * @param hit Filled with the hit parameter, point and normal if
+			 * the ray hits (the body index is left untouched)
+			 * @return true if the ray hits within [0, ray.maxT]
+			 */
+			bool raycast(const Ray& ray, RaycastHit& hit) const;
 
-		protected:
 			enum Type
 			{
 				e_box = 0,
 				e_sphere = 1,
-				e_typecount = 2
+				e_convexHull = 2,
+				e_capsule = 3,
+				e_typecount = 4
 			};
 
+			[[nodiscard]] inline Type getType() const
+			{
+				return m_objectType;
+			}
+
+			/**
+			 * @brief Returns the rotation of the collider as a matrix, whose
+			 * columns are the local axes of the collider in world space
+			 */
+			[[nodiscard]] inline glm::mat3 getRotationMatrix() const
+			{
+				return m_rotation;
+			}
+
+		protected:
+			Collider(Type type, glm::vec3 position, glm::vec3 rotation,
+			         glm::vec3 scale);
+			Collider(const Collider&) = default;
+			Collider& operator=(const Collider&) = default;
+
 			glm::vec3 m_position;
 			glm::vec3 m_rotate;
 			glm::vec3 m_scale;
-			glm::mat4 m_transform;
 			Type m_objectType;
+
+			/**
+			 * @brief Recomputes the rotation matrix, then the bounds of the
+			 * shape (which may depend on it)
+			 *
+			 * The shape classes call it at the end of their constructors,
+			 * once their own members are set.
+			 */
+			void computeShape();
+
+		private:
+			/**
+			 * @brief Computes the AABB of the shape, rotated and scaled,
+			 * relative to the position
+			 *
+			 * Each child calculates its AABB according to its own shape.
+			 * The rotation matrix is up to date when this is called.
+			 */
+			BVImpl::AABB computeLocalBounds() const;
+
+			glm::mat3 m_rotation;
+			BVImpl::AABB m_localBounds;
 	};
 
 	/** 
 	 * @brief BoxCollider class
 	 *  
-	 * Box shaped collider, holds the shape and transform of the body.
+	 * Box shaped collider, holds the shape and transform of the body. The
+	 * half extents are half the scale, so the box is nothing but its
+	 * transform, and is trivially copyable.
 	 */
 	class BoxCollider : public Collider
 	{
@@ -140,11 +200,18 @@ namespace Physicc
 			            glm::vec3 rotation = glm::vec3(0),
 			            glm::vec3 scale = glm::vec3(1));
 
-			[[nodiscard]] BoundingVolume::AABB getAABB() const override;
-			glm::vec3 getCentroid() const override;
+			[[nodiscard]] glm::vec3 getCentroid() const;
+			bool raycast(const Ray& ray, RaycastHit& hit) const;
+
+			[[nodiscard]] inline glm::vec3 getHalfExtents() const
+			{
+				return m_scale * 0.5f;
+			}
 
 		private:
-			std::vector<glm::vec4> m_vertices;
+			BVImpl::AABB computeLocalBounds() const;
+
+			friend class Collider;
 	};
 
 	/** 
@@ -160,13 +227,226 @@ namespace Physicc
 			               glm::vec3 rotation = glm::vec3(0),
 			               glm::vec3 scale = glm::vec3(1));
 
-			[[nodiscard]] BoundingVolume::AABB getAABB() const override;
+			[[nodiscard]] glm::vec3 getCentroid() const;
+			bool raycast(const Ray& ray, RaycastHit& hit) const;
+
+			[[nodiscard]] inline float getRadius() const
+			{
+				return m_radius;
+			}
 
-			glm::vec3 getCentroid() const override;
+			/**
+			 * @brief Same as Collider::getAABB(), without going through the
+			 * cache, for loops that only run over spheres
+			 */
+			[[nodiscard]] inline BoundingVolume::AABB getAABB() const
+			{
+				return {m_position - m_radius, m_position + m_radius};
+			}
 
 		private:
+			BVImpl::AABB computeLocalBounds() const;
+
 			float m_radius;
+
+			friend class Collider;
 	};
+
+	/**
+	 * @brief CapsuleCollider class
+	 *
+	 * A segment along the local y axis, grown by a radius: a cylinder capped
+	 * by two half spheres. Like spheres, capsules ignore the scale.
+	 */
+	class CapsuleCollider : public Collider
+	{
+		public:
+			/**
+			 * @param halfHeight Half the length of the segment, so the
+			 * capsule is 2 * (halfHeight + radius) long
+			 */
+			CapsuleCollider(float radius = 0.5f,
+			                float halfHeight = 0.5f,
+			                glm::vec3 position = glm::vec3(0),
+			                glm::vec3 rotation = glm::vec3(0),
+			                glm::vec3 scale = glm::vec3(1));
+
+			[[nodiscard]] glm::vec3 getCentroid() const;
+			bool raycast(const Ray& ray, RaycastHit& hit) const;
+
+			[[nodiscard]] inline float getRadius() const
+			{
+				return m_radius;
+			}
+
+			[[nodiscard]] inline float getHalfHeight() const
+			{
+				return m_halfHeight;
+			}
+
+		private:
+			BVImpl::AABB computeLocalBounds() const;
+
+			float m_radius;
+			float m_halfHeight;
+
+			friend class Collider;
+	};
+
+	/**
+	 * @brief The geometry of a convex hull, shared by every collider of
+	 * that shape
+	 *
+	 * Given by a point cloud, whose convex hull is the shape. Only the
+	 * support function of the hull is ever used, so the points don't need
+	 * to be the hull's vertices exactly: points inside the hull are
+	 * allowed, just wasteful.
+	 */
+	class ConvexHull
+	{
+		public:
+			/**
+			 * @param vertices Points in local space, before scaling
+			 */
+			explicit ConvexHull(std::vector<glm::vec3> vertices);
+
+			[[nodiscard]] inline const std::vector<glm::vec3>&
+			getVertices() const
+			{
+				return m_vertices;
+			}
+
+			/**
+			 * @brief Average of the points, in local space
+			 */
+			[[nodiscard]] inline glm::vec3 getCentroid() const
+			{
+				return m_centroid;
+			}
+
+		private:
+			std::vector<glm::vec3> m_vertices;
+			glm::vec3 m_centroid;
+	};
+
+	/**
+	 * @brief ConvexHullCollider class
+	 *
+	 * Places a ConvexHull in the world. The collider only refers to the
+	 * hull, which has to outlive every collider (and body) made from it,
+	 * so that many bodies can share one hull, and copying the collider
+	 * doesn't copy the points.
+	 */
+	class ConvexHullCollider : public Collider
+	{
+		public:
+			ConvexHullCollider(const ConvexHull& hull,
+			                   glm::vec3 position = glm::vec3(0),
+			                   glm::vec3 rotation = glm::vec3(0),
+			                   glm::vec3 scale = glm::vec3(1));
+
+			[[nodiscard]] glm::vec3 getCentroid() const;
+			bool raycast(const Ray& ray, RaycastHit& hit) const;
+
+			[[nodiscard]] inline const ConvexHull& getHull() const
+			{
+				return *m_hull;
+			}
+
+			[[nodiscard]] inline const std::vector<glm::vec3>&
+			getVertices() const
+			{
+				return m_hull->getVertices();
+			}
+
+		private:
+			BVImpl::AABB computeLocalBounds() const;
+
+			const ConvexHull* m_hull;
+
+			friend class Collider;
+	};
+
+	/**
+	 * @brief A collider of any shape, held by value
+	 *
+	 * A tagged union of the shape classes, as big as the largest of them,
+	 * and trivially copyable like them. It converts implicitly from every
+	 * shape class, so it can be passed wherever a collider of some shape is
+	 * expected (e.g. RigidBody::setCollider).
+	 */
+	class ColliderShape
+	{
+		public:
+			ColliderShape() : m_type(Collider::e_box), m_box()
+			{
+			}
+
+			ColliderShape(const BoxCollider& box)
+				: m_type(Collider::e_box), m_box(box)
+			{
+			}
+
+			ColliderShape(const SphereCollider& sphere)
+				: m_type(Collider::e_sphere), m_sphere(sphere)
+			{
+			}
+
+			ColliderShape(const ConvexHullCollider& hull)
+				: m_type(Collider::e_convexHull), m_hull(hull)
+			{
+			}
+
+			ColliderShape(const CapsuleCollider& capsule)
+				: m_type(Collider::e_capsule), m_capsule(capsule)
+			{
+			}
+
+			/**
+			 * @brief Copies a collider, whatever its shape
+			 */
+			static ColliderShape fromCollider(const Collider& collider);
+
+			[[nodiscard]] inline Collider::Type getType() const
+			{
+				return m_type;
+			}
+
+			[[nodiscard]] inline const Collider& get() const
+			{
+				switch (m_type)
+				{
+					case Collider::e_box:
+						return m_box;
+					case Collider::e_sphere:
+						return m_sphere;
+					case Collider::e_capsule:
+						return m_capsule;
+					default:
+						return m_hull;
+				}
+			}
+
+			[[nodiscard]] inline Collider& get()
+			{
+				return const_cast<Collider&>(
+					static_cast<const ColliderShape&>(*this).get());
+			}
+
+		private:
+			Collider::Type m_type;
+
+			union
+			{
+				BoxCollider m_box;
+				SphereCollider m_sphere;
+				ConvexHullCollider m_hull;
+				CapsuleCollider m_capsule;
+			};
+	};
+
+	static_assert(std::is_trivially_copyable<ColliderShape>::value,
+	              "copying a collider must not allocate");
 }
 
 #endif // __COLLIDER_H__
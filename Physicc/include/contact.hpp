@@ -0,0 +1,115 @@
+#ifndef __CONTACT_H__
+#define __CONTACT_H__
+
+#include "tools/Tracy.hpp"
+
+#include "glm/glm.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A single point of contact between two colliders
+	 */
+	struct ContactPoint
+	{
+		glm::vec3 position;
+		//halfway between the two surfaces
+		float penetration;
+		//depth along the manifold normal, positive when overlapping
+		std::uint32_t feature;
+		//identifies the pair of features (faces, edges, vertices) that made
+		//this point, so it can be matched with the same point next frame
+	};
+
+	/**
+	 * @brief Up to four contact points sharing one normal
+	 *
+	 * The normal is a unit vector pointing from the first collider to the
+	 * second, i.e. moving the second collider along it separates them.
+	 */
+	struct ContactManifold
+	{
+		static constexpr std::size_t maxPoints = 4;
+
+		std::size_t first;
+		std::size_t second;
+		glm::vec3 normal;
+		std::uint32_t pointCount;
+		ContactPoint points[maxPoints];
+	};
+
+	/**
+	 * @brief Preallocated storage for the manifolds of one step
+	 *
+	 * The storage only ever grows, and is reused from step to step, so the
+	 * narrowphase doesn't allocate once the scene has settled.
+	 */
+	class ContactBuffer
+	{
+		public:
+			/**
+			 * @brief Empties the buffer and makes room for at least
+			 * capacity manifolds
+			 */
+			inline void reset(std::size_t capacity)
+			{
+				if (m_manifolds.size() < capacity)
+				{
+					m_manifolds.resize(capacity);
+				}
+
+				m_size = 0;
+			}
+
+			/**
+			 * @brief Returns the next free manifold, to be filled in and
+			 * then either committed or abandoned
+			 *
+			 * Must only be called while size() < capacity().
+			 */
+			[[nodiscard]] inline ContactManifold& next()
+			{
+				return m_manifolds[m_size];
+			}
+
+			inline void commit()
+			{
+				m_size++;
+			}
+
+			[[nodiscard]] inline std::size_t size() const
+			{
+				return m_size;
+			}
+
+			[[nodiscard]] inline std::size_t capacity() const
+			{
+				return m_manifolds.size();
+			}
+
+			[[nodiscard]] inline const ContactManifold&
+			operator[](std::size_t index) const
+			{
+				return m_manifolds[index];
+			}
+
+			[[nodiscard]] inline const ContactManifold* begin() const
+			{
+				return m_manifolds.data();
+			}
+
+			[[nodiscard]] inline const ContactManifold* end() const
+			{
+				return m_manifolds.data() + m_size;
+			}
+
+		private:
+			std::vector<ContactManifold> m_manifolds;
+			std::size_t m_size = 0;
+	};
+}
+
+#endif //__CONTACT_H__
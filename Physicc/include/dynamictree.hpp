@@ -0,0 +1,229 @@
+#ifndef __DYNAMICTREE_H__
+#define __DYNAMICTREE_H__
+
+#include "tools/Tracy.hpp"
+
+#include "boundingvolume.hpp"
+#include "broadphase.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A single node of the dynamic AABB tree
+	 *
+	 * Nodes live in a pool and refer to each other by index, so the tree can
+	 * grow without invalidating any handle. Free nodes are chained through
+	 * `parent`, and are recognised by a height of -1.
+	 */
+	struct DynamicTreeNode
+	{
+		static constexpr std::uint32_t nullIndex = ~std::uint32_t(0);
+
+		BoundingVolume::AABB volume;
+		std::uint32_t parent = nullIndex;
+		std::uint32_t left = nullIndex;
+		std::uint32_t right = nullIndex;
+		std::int32_t height = -1;
+		std::size_t body = 0;
+
+		[[nodiscard]] inline bool isLeaf() const
+		{
+			return left == nullIndex;
+		}
+	};
+
+	/**
+	 * @brief Incrementally updated AABB tree for moving bodies
+	 *
+	 * Every leaf stores a "fat" AABB, i.e. the body's AABB grown by a margin.
+	 * Moving a body only touches the tree once its actual AABB leaves the fat
+	 * one, so slow bodies cost next to nothing per frame. The tree is kept
+	 * balanced with AVL-style rotations on every insertion and removal.
+	 */
+	class DynamicTree
+	{
+		public:
+			DynamicTree(float margin = 0.1f);
+
+			/**
+			 * @brief Inserts a body in the tree
+			 *
+			 * @param volume The (tight) AABB of the body
+			 * @param body An identifier for the body, returned by queries
+			 * @return A proxy to refer to this body in the tree
+			 */
+			std::uint32_t insert(const BoundingVolume::AABB& volume,
+			                     std::size_t body);
+
+			void remove(std::uint32_t proxy);
+
+			/**
+			 * @brief Updates the AABB of a body
+			 *
+			 * @return true if the body left its fat AABB and was reinserted,
+			 * false if the tree was left untouched
+			 */
+			bool move(std::uint32_t proxy, const BoundingVolume::AABB& volume);
+
+			[[nodiscard]] inline const BoundingVolume::AABB&
+			getFatAABB(std::uint32_t proxy) const
+			{
+				return m_nodes[proxy].volume;
+			}
+
+			[[nodiscard]] inline std::size_t getBody(std::uint32_t proxy) const
+			{
+				return m_nodes[proxy].body;
+			}
+
+			[[nodiscard]] inline float getMargin() const
+			{
+				return m_margin;
+			}
+
+			[[nodiscard]] inline std::int32_t getHeight() const
+			{
+				return m_root == DynamicTreeNode::nullIndex
+					? 0
+					: m_nodes[m_root].height;
+			}
+
+			/**
+			 * @brief Calls callback(body) for every fat AABB overlapping volume
+			 *
+			 * The callback returns false to stop the query early. Queries
+			 * don't write to the tree, so any number of them may run at
+			 * once, as long as nothing modifies the tree meanwhile.
+			 *
+			 * @return The number of nodes visited, for profiling
+			 */
+			template <typename Callback>
+			std::size_t query(const BoundingVolume::AABB& volume,
+			           Callback&& callback) const;
+
+		private:
+			static constexpr std::int32_t maxQueryDepth = 64;
+			//The tree is AVL balanced, so its height is under
+			//1.45 * log2(node count) < 48, and a depth-first walk never has
+			//more than height + 1 nodes on its stack. Taller trees, which
+			//only a balancing bug can produce, fall back to a heap stack
+
+			std::vector<DynamicTreeNode> m_nodes;
+
+			std::uint32_t m_root;
+			std::uint32_t m_freeList;
+			float m_margin;
+
+			std::uint32_t allocateNode();
+			void freeNode(std::uint32_t node);
+
+			void insertLeaf(std::uint32_t leaf);
+			void removeLeaf(std::uint32_t leaf);
+
+			std::uint32_t balance(std::uint32_t node);
+			void refitAncestors(std::uint32_t node);
+	};
+
+	template <typename Callback>
+	std::size_t DynamicTree::query(const BoundingVolume::AABB& volume,
+	                               Callback&& callback) const
+	{
+		std::size_t visited = 0;
+
+		if (m_root == DynamicTreeNode::nullIndex)
+		{
+			return visited;
+		}
+
+		std::uint32_t fixedStack[maxQueryDepth];
+		std::vector<std::uint32_t> heapStack;
+		std::uint32_t* stack = fixedStack;
+
+		if (m_nodes[m_root].height >= maxQueryDepth)
+		{
+			auto height = static_cast<std::size_t>(m_nodes[m_root].height);
+			heapStack.resize(height + 1);
+			stack = heapStack.data();
+		}
+
+		std::int32_t size = 0;
+		stack[size++] = m_root;
+
+		while (size > 0)
+		{
+			const auto& node = m_nodes[stack[--size]];
+			visited++;
+
+			if (!node.volume.overlapsWith(volume))
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				if (!callback(node.body))
+				{
+					return visited;
+				}
+			} else
+			{
+				stack[size++] = node.left;
+				stack[size++] = node.right;
+			}
+		}
+
+		return visited;
+	}
+
+	/**
+	 * @brief Broadphase backed by a DynamicTree
+	 *
+	 * Best suited for scenes where most bodies move slowly, as only bodies
+	 * that leave their fat AABB touch the tree.
+	 *
+	 * The pairs are kept from one call of findPairs to the next. Only the
+	 * bodies whose fat AABB changed since the last call (the move buffer)
+	 * query the tree: their old pairs are dropped and their current ones
+	 * found again, while the pairs of bodies that stayed inside their fat
+	 * AABB can't have changed, and are kept as they are. A frame in which
+	 * nothing left its fat AABB costs a copy of the pairs.
+	 */
+	class DynamicTreeBroadphase : public Broadphase
+	{
+		public:
+			DynamicTreeBroadphase(float margin = 0.1f);
+
+			[[nodiscard]] inline Type getType() const override
+			{
+				return e_dynamicTree;
+			}
+
+			void insert(std::size_t body,
+			            const BoundingVolume::AABB& volume) override;
+			void remove(std::size_t body) override;
+			void update(std::size_t body,
+			            const BoundingVolume::AABB& volume) override;
+			void findPairs(std::vector<CollisionPair>& pairs) override;
+
+			[[nodiscard]] inline const DynamicTree& getTree() const
+			{
+				return m_tree;
+			}
+
+		private:
+			DynamicTree m_tree;
+			std::vector<std::uint32_t> m_proxies;
+			//m_proxies[body] is the handle of body in m_tree
+
+			std::vector<CollisionPair> m_pairs;
+			std::vector<std::size_t> m_moveBuffer;
+			std::vector<bool> m_moved;
+			//m_moved[body] is whether body is in m_moveBuffer
+
+			void addMoved(std::size_t body);
+	};
+}
+
+#endif //__DYNAMICTREE_H__
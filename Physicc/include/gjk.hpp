@@ -0,0 +1,147 @@
+#ifndef __GJK_H__
+#define __GJK_H__
+
+#include "tools/Tracy.hpp"
+
+#include "glm/glm.hpp"
+#include "collider.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A convex shape, as seen by GJK and EPA
+	 *
+	 * Only knows how to return its furthest point along a direction (its
+	 * support point). The world transform is resolved once when the shape is
+	 * made, since GJK queries the support function many times per pair.
+	 */
+	class ConvexShape
+	{
+		public:
+			/**
+			 * @brief Makes the shape of a collider of any shape
+			 */
+			static ConvexShape fromCollider(const Collider& collider);
+
+			/**
+			 * @brief Makes a single point, e.g. to measure the distance from a
+			 * point to a collider
+			 */
+			static ConvexShape fromPoint(const glm::vec3& point);
+
+			[[nodiscard]] glm::vec3
+			getSupport(const glm::vec3& direction) const;
+
+			[[nodiscard]] inline glm::vec3 getCenter() const
+			{
+				return m_center;
+			}
+
+			/**
+			 * @brief Converts a world space point to the shape's local frame
+			 * and back, so that points can be cached across frames while the
+			 * shape moves
+			 */
+			[[nodiscard]] inline glm::vec3 toLocal(const glm::vec3& point) const
+			{
+				return glm::transpose(m_axes) * (point - m_center);
+			}
+
+			[[nodiscard]] inline glm::vec3 toWorld(const glm::vec3& point) const
+			{
+				return m_center + m_axes * point;
+			}
+
+		private:
+			enum Kind
+			{
+				e_point = 0,
+				e_box = 1,
+				e_sphere = 2,
+				e_hull = 3,
+				e_capsule = 4
+			};
+
+			Kind m_kind = e_point;
+			glm::vec3 m_center = glm::vec3(0.0f);
+			glm::mat3 m_axes = glm::mat3(1.0f);
+			glm::vec3 m_extents = glm::vec3(0.0f);
+			//half extents of boxes, scale of hulls, radius of spheres (in x),
+			//radius and half height of capsules (in x and y)
+			const std::vector<glm::vec3>* m_vertices = nullptr;
+	};
+
+	/**
+	 * @brief The simplex GJK ended with for a pair, kept to start the next
+	 * query for that pair from
+	 *
+	 * Its points are stored in the local frames of the two shapes, so they
+	 * remain points of the shapes after the shapes move. For bodies that
+	 * barely moved (resting contacts) the cached simplex is already (close
+	 * to) the final one, and GJK converges in one or two iterations.
+	 */
+	struct SimplexCache
+	{
+		std::uint32_t count = 0;
+		glm::vec3 localA[4];
+		glm::vec3 localB[4];
+	};
+
+	/**
+	 * @brief A vertex of the Minkowski difference A - B, along with the
+	 * points of A and B it came from
+	 */
+	struct SupportPoint
+	{
+		glm::vec3 point;
+		glm::vec3 pointA;
+		glm::vec3 pointB;
+	};
+
+	struct GJKResult
+	{
+		bool intersecting;
+		float distance;
+		//0 if the shapes intersect
+		glm::vec3 pointA;
+		glm::vec3 pointB;
+		//closest points of the shapes, if they don't intersect
+		std::uint32_t iterations;
+
+		SupportPoint simplex[4];
+		std::uint32_t simplexCount;
+		//final simplex, which EPA starts from
+	};
+
+	struct PenetrationResult
+	{
+		glm::vec3 normal;
+		//unit vector from A to B: moving B by normal * depth separates them
+		float depth;
+		glm::vec3 pointA;
+		glm::vec3 pointB;
+		//deepest points of A inside B and of B inside A
+	};
+
+	/**
+	 * @brief Computes the distance between two convex shapes with GJK
+	 *
+	 * @param cache If not null, the search starts from the simplex cached
+	 * in it, and the final simplex is stored back into it
+	 */
+	GJKResult computeDistance(const ConvexShape& a, const ConvexShape& b,
+	                          SimplexCache* cache = nullptr);
+
+	/**
+	 * @brief Computes how deep two intersecting shapes are with EPA,
+	 * starting from the simplex GJK ended with
+	 *
+	 * @return false if the polytope couldn't be expanded (degenerate shapes)
+	 */
+	bool computePenetration(const ConvexShape& a, const ConvexShape& b,
+	                        const GJKResult& gjk, PenetrationResult& result);
+}
+
+#endif //__GJK_H__
@@ -0,0 +1,43 @@
+#ifndef __INTEGRATOR_H__
+#define __INTEGRATOR_H__
+
+#include "tools/Tracy.hpp"
+
+#include "glm/glm.hpp"
+#include "bodystorage.hpp"
+
+namespace Physicc
+{
+	/**
+	 * @brief Advances every awake body by one step of semi-implicit Euler
+	 *
+	 * Velocities are updated first, from gravity (scaled per body) and the
+	 * forces accumulated since the last step, and positions are then moved
+	 * with the new velocities:
+	 *
+	 *     v += (gravity * gravityScale + force * inverseMass) * timestep
+	 *     x += v * timestep
+	 *
+	 * Static bodies (inverse mass 0) ignore gravity and forces, but still
+	 * move with whatever velocity they are given. The accumulated forces
+	 * are cleared afterwards.
+	 */
+	void integrate(BodyStorage& bodies, const glm::vec3& gravity,
+	               float timestep);
+
+	/**
+	 * @brief The velocity half of integrate(), which also clears the forces
+	 *
+	 * Split from the position half so that a solver can correct the new
+	 * velocities before the bodies are moved with them.
+	 */
+	void integrateVelocities(BodyStorage& bodies, const glm::vec3& gravity,
+	                         float timestep);
+
+	/**
+	 * @brief The position half of integrate()
+	 */
+	void integratePositions(BodyStorage& bodies, float timestep);
+}
+
+#endif //__INTEGRATOR_H__
@@ -0,0 +1,85 @@
+#ifndef __ISLAND_H__
+#define __ISLAND_H__
+
+#include "tools/Tracy.hpp"
+
+#include "allocator.hpp"
+#include "bodystorage.hpp"
+#include "contact.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A set of awake bodies connected by contacts, along with those
+	 * contacts
+	 *
+	 * The ranges index into IslandBuilder::getBodies() and
+	 * IslandBuilder::getContacts().
+	 */
+	struct Island
+	{
+		std::uint32_t firstBody;
+		std::uint32_t bodyCount;
+		std::uint32_t firstContact;
+		std::uint32_t contactCount;
+	};
+
+	/**
+	 * @brief Splits the awake bodies into islands, with union-find over the
+	 * contact graph
+	 *
+	 * Static bodies don't connect islands: two stacks resting on the same
+	 * ground are separate islands. A contact with a static body belongs to
+	 * the island of the other body, and an awake static body (e.g. one
+	 * moved by setting its velocity) is an island of its own.
+	 */
+	class IslandBuilder
+	{
+		public:
+			/**
+			 * @param contacts Manifolds whose bodies are identified by their
+			 * slot, and aren't both asleep
+			 */
+			void build(const BodyStorage& bodies,
+			           const ContactBuffer& contacts);
+
+			[[nodiscard]] inline const std::vector<Island>& getIslands() const
+			{
+				return m_islands;
+			}
+
+			/**
+			 * @brief Dense indices of the awake bodies, grouped by island
+			 */
+			[[nodiscard]] inline const AlignedVector<std::uint32_t>&
+			getBodies() const
+			{
+				return m_bodies;
+			}
+
+			/**
+			 * @brief Indices of the contact manifolds, grouped by island
+			 */
+			[[nodiscard]] inline const AlignedVector<std::uint32_t>&
+			getContacts() const
+			{
+				return m_contacts;
+			}
+
+		private:
+			std::uint32_t find(std::uint32_t body);
+
+			AlignedVector<std::uint32_t> m_parents;
+			AlignedVector<std::uint32_t> m_islandOf;
+			//island of each root, then of each body
+			AlignedVector<std::uint32_t> m_contactIslands;
+
+			std::vector<Island> m_islands;
+			AlignedVector<std::uint32_t> m_bodies;
+			AlignedVector<std::uint32_t> m_contacts;
+	};
+}
+
+#endif //__ISLAND_H__
@@ -0,0 +1,75 @@
+#ifndef __NARROWPHASE_H__
+#define __NARROWPHASE_H__
+
+#include "tools/Tracy.hpp"
+
+#include "collider.hpp"
+#include "contact.hpp"
+#include "gjk.hpp"
+#include <cstdint>
+#include <unordered_map>
+
+namespace Physicc
+{
+	/**
+	 * @brief Narrowphase class
+	 *
+	 * Generates the contact manifold of a pair of colliders, with one
+	 * routine per pair of shapes. The routine is looked up in a table
+	 * indexed by the Collider::Type of both colliders, instead of going
+	 * through a virtual double dispatch.
+	 *
+	 * Pairs involving a convex hull go through GJK and EPA. The simplex GJK
+	 * ends with is cached per pair, to start the pair's next query from.
+	 */
+	class Narrowphase
+	{
+		public:
+			/**
+			 * @brief Computes the contacts between two colliders
+			 *
+			 * @param manifold Filled with the normal (from a to b) and the
+			 * contact points. Its first and second members must be set by
+			 * the caller beforehand, as they identify the pair in the
+			 * simplex cache.
+			 * @return true if the colliders touch
+			 */
+			bool collide(const Collider& a, const Collider& b,
+			             ContactManifold& manifold);
+
+			/**
+			 * @brief Drops the cached simplices of the pairs that weren't
+			 * tested since the last call, i.e. that left the broadphase
+			 */
+			void pruneCache();
+
+		private:
+			using ContactFunction = bool (Narrowphase::*)(const Collider&,
+			                                              const Collider&,
+			                                              ContactManifold&);
+
+			static const ContactFunction
+				s_dispatch[Collider::e_typecount][Collider::e_typecount];
+
+			bool boxBox(const Collider& a, const Collider& b,
+			            ContactManifold& manifold);
+			bool boxSphere(const Collider& a, const Collider& b,
+			               ContactManifold& manifold);
+			bool sphereBox(const Collider& a, const Collider& b,
+			               ContactManifold& manifold);
+			bool sphereSphere(const Collider& a, const Collider& b,
+			                  ContactManifold& manifold);
+			bool convexConvex(const Collider& a, const Collider& b,
+			                  ContactManifold& manifold);
+
+			struct CachedPair
+			{
+				SimplexCache simplex;
+				bool used;
+			};
+
+			std::unordered_map<std::uint64_t, CachedPair> m_simplexCache;
+	};
+}
+
+#endif //__NARROWPHASE_H__
@@ -5,6 +5,16 @@
 
 #include "glm/glm.hpp"
 #include "rigidbody.hpp"
+#include "bodystorage.hpp"
+#include "ccd.hpp"
+#include "broadphase.hpp"
+#include "contact.hpp"
+#include "island.hpp"
+#include "narrowphase.hpp"
+#include "solver.hpp"
+#include "threadpool.hpp"
+#include <cassert>
+#include <memory>
 #include <vector>
 
 namespace Physicc
@@ -18,28 +28,253 @@ namespace Physicc
 	class PhysicsWorld
 	{
 		public:
-			PhysicsWorld(const glm::vec3& gravity);
+			PhysicsWorld(const glm::vec3& gravity,
+			             Broadphase::Type broadphase =
+			                 Broadphase::e_dynamicTree);
 
 			inline void setGravity(const glm::vec3& gravity)
 			{
-				ZoneScoped;
-
 				m_gravity = gravity;
 			}
 
 			[[nodiscard]] inline glm::vec3 getGravity() const
 			{
-				ZoneScoped;
-
 				return m_gravity;
 			}
 
-			void addRigidBody(const RigidBody& object);
+			BodyHandle addRigidBody(const RigidBody& object);
+			void removeRigidBody(BodyHandle handle);
+
+			/**
+			 * @brief Adds a force to the ones applied to a body during the
+			 * next step
+			 *
+			 * Forces are accumulated until the next call to stepSimulation,
+			 * and cleared after it, so continuous forces must be applied
+			 * again every step.
+			 */
+			inline void applyForce(BodyHandle handle, const glm::vec3& force)
+			{
+				m_bodies.wake(handle.index);
+				m_bodies.getForces()[m_bodies.getIndex(handle)] += force;
+			}
+
+			/**
+			 * @brief Wakes the island of a body
+			 *
+			 * Needed after changing a body through getBodies() (e.g. its
+			 * velocity), since sleeping bodies are skipped by every step.
+			 */
+			inline void wake(BodyHandle handle)
+			{
+				m_bodies.wake(handle.index);
+			}
+
+			/**
+			 * @brief Sets the speed under which bodies count as resting.
+			 * Default = 0.05
+			 */
+			inline void setSleepThreshold(float speed)
+			{
+				m_sleepThreshold = speed;
+			}
+
+			[[nodiscard]] inline float getSleepThreshold() const
+			{
+				return m_sleepThreshold;
+			}
+
+			/**
+			 * @brief Sets how long every body of an island has to rest
+			 * before the island falls asleep. Default = 0.5
+			 *
+			 * An infinite time disables sleeping.
+			 */
+			inline void setTimeToSleep(float time)
+			{
+				m_timeToSleep = time;
+			}
+
+			[[nodiscard]] inline float getTimeToSleep() const
+			{
+				return m_timeToSleep;
+			}
 			void stepSimulation(float timestep);
 
+			/**
+			 * @brief Advances the simulation by frameTime, in fixed steps
+			 *
+			 * The frame time is added to an accumulator, which is then
+			 * consumed in steps of the fixed timestep, so the simulation
+			 * doesn't depend on the frame rate. At most maxSubsteps steps
+			 * are taken per call: when the simulation can't keep up, the
+			 * time it is behind by is dropped (the simulation slows down)
+			 * instead of piling up ever more steps per frame.
+			 *
+			 * @return The number of steps taken
+			 */
+			int update(float frameTime);
+
+			/**
+			 * @brief Sets the length of the steps update() takes.
+			 * Default = 1/60
+			 *
+			 * @param timestep Has to be positive
+			 */
+			inline void setFixedTimestep(float timestep)
+			{
+				assert(timestep > 0.0f
+				       && "the fixed timestep has to be positive");
+				m_fixedTimestep = timestep;
+			}
+
+			[[nodiscard]] inline float getFixedTimestep() const
+			{
+				return m_fixedTimestep;
+			}
+
+			inline void setMaxSubsteps(int maxSubsteps)
+			{
+				m_maxSubsteps = maxSubsteps;
+			}
+
+			[[nodiscard]] inline int getMaxSubsteps() const
+			{
+				return m_maxSubsteps;
+			}
+
+			/**
+			 * @brief Returns how far the accumulated time is into the next
+			 * step, in [0, 1)
+			 *
+			 * Rendering bodies at mix(previous, current, alpha) hides the
+			 * mismatch between the fixed step and the frame rate.
+			 */
+			[[nodiscard]] inline float getInterpolationAlpha() const
+			{
+				return m_fixedTimestep > 0.0f
+					? m_accumulator / m_fixedTimestep
+					: 0.0f;
+			}
+
+			/**
+			 * @brief Returns the position of a body, interpolated between
+			 * the last two steps with the interpolation alpha
+			 */
+			[[nodiscard]] glm::vec3
+			getInterpolatedPosition(BodyHandle handle) const;
+
+			/**
+			 * @brief Sets how many iterations the contact solver runs per
+			 * step, trading accuracy for time. Default = 8
+			 */
+			inline void setSolverIterations(int iterations)
+			{
+				m_solver.setIterations(iterations);
+			}
+
+			[[nodiscard]] inline int getSolverIterations() const
+			{
+				return m_solver.getIterations();
+			}
+
+			/**
+			 * @brief Sets how many threads the contact solver runs on,
+			 * counting the one calling stepSimulation. Default = 1
+			 *
+			 * The results of a step don't depend on the number of threads.
+			 */
+			void setThreadCount(std::size_t threads);
+
+			[[nodiscard]] inline std::size_t getThreadCount() const
+			{
+				return m_threads->getThreadCount();
+			}
+
+			[[nodiscard]] inline BodyStorage& getBodies()
+			{
+				return m_bodies;
+			}
+
+			[[nodiscard]] inline const BodyStorage& getBodies() const
+			{
+				return m_bodies;
+			}
+
+			/**
+			 * @brief Switches to another broadphase algorithm
+			 *
+			 * Every body is reinserted in the new broadphase.
+			 */
+			void setBroadphase(Broadphase::Type type);
+
+			[[nodiscard]] inline const Broadphase& getBroadphase() const
+			{
+				return *m_broadphase;
+			}
+
+			//pairs of bodies whose AABBs may overlap, as found by the last
+			//call to stepSimulation. Bodies are identified by their slot (see
+			//BodyStorage::getSlot).
+			[[nodiscard]] inline const std::vector<CollisionPair>&
+			getPairs() const
+			{
+				return m_pairs;
+			}
+
+			//contact manifolds found by the last call to stepSimulation,
+			//with bodies identified by their slot
+			[[nodiscard]] inline const ContactBuffer& getContacts() const
+			{
+				return m_contacts;
+			}
+
 		private:
 			glm::vec3 m_gravity;
-			std::vector<RigidBody> m_objects;
+			BodyStorage m_bodies;
+
+			float m_fixedTimestep;
+			float m_accumulator;
+			int m_maxSubsteps;
+
+			std::unique_ptr<Broadphase> m_broadphase;
+			std::vector<CollisionPair> m_pairs;
+			AlignedVector<BoundingVolume::AABB> m_volumes;
+			//of the awake bodies, by dense index
+
+			Narrowphase m_narrowphase;
+			ContactBuffer m_contacts;
+			ContactSolver m_solver;
+			std::unique_ptr<ThreadPool> m_threads;
+
+			IslandBuilder m_islands;
+			float m_sleepThreshold;
+			float m_timeToSleep;
+			std::vector<std::size_t> m_sleepingPairs;
+			std::vector<std::uint32_t> m_sleepingSlots;
+			std::vector<std::size_t> m_sleepingSizes;
+
+			/**
+			 * @brief The motion of a fast CCD body over a step, and the
+			 * earliest impact found along it
+			 */
+			struct Sweep
+			{
+				std::uint32_t index;
+				glm::vec3 displacement;
+				TimeOfImpact impact;
+				glm::vec3 targetDisplacement;
+				//of the body hit, which the swept body moves along with
+				//after the impact
+			};
+
+			std::vector<Sweep> m_sweeps;
+			AlignedVector<std::uint32_t> m_sweepOfSlot;
+
+			void updateBroadphase(float timestep);
+			void updateContacts();
+			void updateContinuous();
+			void updateSleep(float timestep);
 	};
 }
 
@@ -0,0 +1,47 @@
+#ifndef __PROFILING_H__
+#define __PROFILING_H__
+
+#include "tools/Tracy.hpp"
+
+#include <cstdint>
+
+/**
+ * Physicc instruments itself in tiers, so that profiling a step with 100k
+ * bodies measures the engine rather than the profiler:
+ *
+ * - Coarse zones (one per phase of a step, like building the BVH or finding
+ *   pairs) use plain `ZoneScoped`, and are on whenever Tracy is.
+ * - Counters (pairs tested, nodes visited...) are accumulated per phase and
+ *   sent to Tracy as plots, from PHYSICC_PROFILE_LEVEL 1 onwards.
+ * - Fine zones, in functions called once per body or per query, only exist
+ *   from PHYSICC_PROFILE_LEVEL 2 onwards.
+ *
+ * Trivial accessors are never instrumented. PHYSICC_PROFILE_LEVEL defaults
+ * to 1, and can be overridden from the build (-DPHYSICC_PROFILE_LEVEL=2).
+ */
+#ifndef PHYSICC_PROFILE_LEVEL
+	#define PHYSICC_PROFILE_LEVEL 1
+#endif
+
+#if defined(TRACY_ENABLE) && PHYSICC_PROFILE_LEVEL >= 2
+	#define PhysiccZoneFine ZoneScoped
+	#define PhysiccZoneFineN(name) ZoneScopedN(name)
+#else
+	#define PhysiccZoneFine
+	#define PhysiccZoneFineN(name)
+#endif
+
+#if defined(TRACY_ENABLE) && PHYSICC_PROFILE_LEVEL >= 1
+	#define PhysiccCounter(counter) std::int64_t counter = 0
+	#define PhysiccCount(counter, amount) (counter += (amount))
+	#define PhysiccPlot(name, counter) TracyPlot(name, counter)
+#else
+	#define PhysiccCounter(counter)
+	#define PhysiccCount(counter, amount) ((void)sizeof(amount))
+	#define PhysiccPlot(name, counter)
+#endif
+//The counter only exists when it is plotted, so counting compiles away to
+//nothing in builds without profiling. sizeof keeps the amount "used"
+//without evaluating it.
+
+#endif //__PROFILING_H__
@@ -0,0 +1,66 @@
+#ifndef __RAYCAST_H__
+#define __RAYCAST_H__
+
+#include "glm/glm.hpp"
+#include "boundingvolume.hpp"
+#include <cstddef>
+
+namespace Physicc
+{
+	/**
+	 * @brief A ray, or a segment if maxT is finite
+	 *
+	 * Points on the ray are origin + t * direction, for t in [0, maxT]. The
+	 * direction doesn't have to be normalized, in which case t is measured in
+	 * multiples of its length.
+	 */
+	struct Ray
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		float maxT;
+	};
+
+	/**
+	 * @brief The closest hit of a ray against a collider
+	 *
+	 * Rays starting inside a collider hit it at t = 0, with a normal facing
+	 * back along the ray.
+	 */
+	struct RaycastHit
+	{
+		std::size_t body = 0;
+		float t = 0.0f;
+		glm::vec3 point = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+	};
+
+	/**
+	 * @brief Slab test of a ray against an AABB
+	 *
+	 * @param inverseDirection Component-wise 1 / direction, precomputed once
+	 * per ray since the test is run against many boxes
+	 * @param tEnter Set to the parameter at which the ray enters the box
+	 * (clamped to 0)
+	 * @return true if the ray hits the box within [0, maxT]
+	 */
+	[[nodiscard]] inline bool intersectsSlab(const BoundingVolume::AABB& volume,
+	                                         const glm::vec3& origin,
+	                                         const glm::vec3& inverseDirection,
+	                                         float maxT, float& tEnter)
+	{
+		glm::vec3 t1 = (volume.getLowerBound() - origin) * inverseDirection;
+		glm::vec3 t2 = (volume.getUpperBound() - origin) * inverseDirection;
+		glm::vec3 tMin = glm::min(t1, t2);
+		glm::vec3 tMax = glm::max(t1, t2);
+
+		tEnter = glm::max(glm::max(tMin.x, tMin.y),
+		                  glm::max(tMin.z, 0.0f));
+		float tExit = glm::min(glm::min(tMax.x, tMax.y),
+		                       glm::min(tMax.z, maxT));
+
+		return tEnter <= tExit;
+	}
+}
+
+#endif //__RAYCAST_H__
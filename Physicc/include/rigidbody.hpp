@@ -5,6 +5,7 @@
 
 #include "glm/glm.hpp"
 #include "collider.hpp"
+#include <type_traits>
 
 namespace Physicc
 {
@@ -12,6 +13,9 @@ namespace Physicc
 	 * @brief Rigid Body Class
 	 *
 	 * This class describes and propagates the properties of each Rigid Body.
+	 *
+	 * It is trivially copyable, so bodies can be passed around and stored
+	 * by value (and moved with memcpy) without allocating.
 	 */
 	class RigidBody
 	{
@@ -20,52 +24,137 @@ namespace Physicc
 
 			[[nodiscard]] inline glm::vec3 getVelocity() const
 			{
-				ZoneScoped;
-
 				return m_velocity;
 			}
 
 			
             inline void setVelocity(const glm::vec3& velocity)
 			{
-				ZoneScoped;
-
 				m_velocity = velocity;
 			}
 
 			inline void setGravityScale(const float gravityScale)
 			{
-				ZoneScoped;
-
 				m_gravityScale = gravityScale;
 
 			}
 
-			void setForce();
+			[[nodiscard]] inline float getMass() const
+			{
+				return m_mass;
+			}
+
+			[[nodiscard]] inline float getGravityScale() const
+			{
+				return m_gravityScale;
+			}
 
-			[[nodiscard]] inline BoundingVolume::AABB getAABB() const
+			[[nodiscard]] inline glm::vec3 getForce() const
+			{
+				return m_force;
+			}
+
+			inline void setForce(const glm::vec3& force)
+			{
+				m_force = force;
+			}
+
+			/**
+			 * @brief Friction coefficient, combined with the other body's as
+			 * the geometric mean. Default = 0.5
+			 */
+			[[nodiscard]] inline float getFriction() const
+			{
+				return m_friction;
+			}
+
+			inline void setFriction(float friction)
+			{
+				m_friction = friction;
+			}
+
+			/**
+			 * @brief Restitution (bounciness) in [0, 1], combined with the
+			 * other body's by taking the largest. Default = 0
+			 */
+			[[nodiscard]] inline float getRestitution() const
 			{
-				ZoneScoped;
+				return m_restitution;
+			}
 
-				return m_collider.getAABB();
+			inline void setRestitution(float restitution)
+			{
+				m_restitution = restitution;
+			}
+
+			/**
+			 * @brief Whether the body is swept through each step, rather
+			 * than only tested where the step ends, so that it can't pass
+			 * through thin bodies. Meant for small, fast bodies like
+			 * projectiles. Default = false
+			 */
+			[[nodiscard]] inline bool getCCD() const
+			{
+				return m_ccd;
+			}
+
+			inline void setCCD(bool ccd)
+			{
+				m_ccd = ccd;
+			}
+
+			[[nodiscard]] inline const Collider& getCollider() const
+			{
+				return m_collider.get();
+			}
+
+			[[nodiscard]] inline const ColliderShape& getShape() const
+			{
+				return m_collider;
+			}
+
+			/**
+			 * @brief Sets the collider of the body, of any shape. Default =
+			 * a unit box
+			 */
+			inline void setCollider(const ColliderShape& collider)
+			{
+				m_collider = collider;
+			}
+
+			[[nodiscard]] inline BoundingVolume::AABB getAABB() const
+			{
+				return m_collider.get().getAABB();
 			}
 
 			[[nodiscard]] inline glm::vec3 getCentroid() const
 			{
-				return m_collider.getCentroid();
+				return m_collider.get().getCentroid();
+			}
+
+			[[nodiscard]] inline bool raycast(const Ray& ray,
+			                                  RaycastHit& hit) const
+			{
+				return m_collider.get().raycast(ray, hit);
 			}
 
 		private:
 			glm::vec3 m_force;
-			BoxCollider m_collider;
+			ColliderShape m_collider;
 			float m_mass;
 			glm::vec3 m_velocity;
 			float m_gravityScale;
+			float m_friction;
+			float m_restitution;
+			bool m_ccd;
 
 			friend class PhysicsWorld;
 			//PhysicsWorld needs to have access to all of RigidBody's private
 			//members for functions like stepSimulation, etc.
 	};
+
+	static_assert(std::is_trivially_copyable<RigidBody>::value,
+	              "copying a RigidBody must not allocate");
 }
 
 #endif // __RIGIDBODY_H__
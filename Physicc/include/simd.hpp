@@ -0,0 +1,18 @@
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+//Picks the widest instruction set the compiler was told it may use. Every
+//kernel that uses intrinsics also has a plain scalar version, which is what
+//gets built when neither of these is defined.
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define PHYSICC_AVX
+	#define PHYSICC_SSE2
+	//AVX implies SSE2, so 4-wide kernels are available too
+#elif defined(__SSE2__) || defined(_M_X64) \
+	|| (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define PHYSICC_SSE2
+#endif
+
+#endif //__SIMD_H__
@@ -0,0 +1,161 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include "tools/Tracy.hpp"
+
+#include "glm/glm.hpp"
+#include "allocator.hpp"
+#include "bodystorage.hpp"
+#include "contact.hpp"
+#include "island.hpp"
+#include "threadpool.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief Sequential impulse (projected Gauss-Seidel) contact solver
+	 *
+	 * Every contact point becomes a constraint with one normal row, which
+	 * may only push, and two friction rows, clamped by the friction cone
+	 * (approximated as a box). The constraints are solved one at a time, a
+	 * fixed number of times, each applying at once the impulse that fixes
+	 * its own velocity error.
+	 *
+	 * The impulses accumulated by each contact point are kept until the
+	 * next step, matched by the pair and the point's feature id, and
+	 * applied up front (warm starting). Resting contacts then start close
+	 * to their solution, and stacks stay stable with few iterations.
+	 *
+	 * Bodies only have a linear velocity, so the constraints only have
+	 * linear terms.
+	 *
+	 * Islands share no dynamic body, so they are solved in parallel, small
+	 * ones grouped into tasks. A large island is split into batches by
+	 * greedily coloring its manifolds so that no two manifolds of a batch
+	 * share a dynamic body; the manifolds of a batch are then solved in
+	 * parallel, and the batches one after the other. Static bodies are
+	 * never written to, so they don't need distinct colors. None of this
+	 * depends on the number of threads, so the results don't either.
+	 */
+	class ContactSolver
+	{
+		public:
+			/**
+			 * @brief Sets how many times the constraints are solved per step
+			 *
+			 * More iterations converge better (stiffer stacks, less
+			 * jitter), at a cost linear in the number of iterations.
+			 * Default = 8
+			 */
+			inline void setIterations(int iterations)
+			{
+				m_iterations = iterations;
+			}
+
+			[[nodiscard]] inline int getIterations() const
+			{
+				return m_iterations;
+			}
+
+			/**
+			 * @brief Changes the velocities of the bodies so that they
+			 * respect the contacts
+			 *
+			 * @param contacts Manifolds whose bodies are identified by their
+			 * slot in bodies
+			 * @param islands The islands of the bodies and contacts
+			 */
+			void solve(BodyStorage& bodies, const ContactBuffer& contacts,
+			           const IslandBuilder& islands, float timestep,
+			           ThreadPool& threads);
+
+			[[nodiscard]] inline std::size_t getConstraintCount() const
+			{
+				return m_bodiesA.size();
+			}
+
+		private:
+			struct CachedManifold
+			{
+				std::uint32_t pointCount;
+				std::uint32_t features[ContactManifold::maxPoints];
+				float normalImpulses[ContactManifold::maxPoints];
+				glm::vec3 tangentImpulses[ContactManifold::maxPoints];
+				//in world space, since the tangents change from step to step
+				bool used;
+			};
+
+			struct ManifoldRange
+			{
+				CachedManifold* cache;
+				std::size_t manifold;
+				std::uint32_t first;
+				//first constraint of the manifold
+				std::uint32_t count;
+			};
+
+			/**
+			 * @brief Consecutive manifold ranges, solved as one task
+			 */
+			struct Batch
+			{
+				std::uint32_t firstRange;
+				std::uint32_t rangeCount;
+				bool parallel;
+				//whether its manifolds share no dynamic body
+			};
+
+			struct ColoredIsland
+			{
+				std::uint32_t firstBatch;
+				std::uint32_t batchCount;
+			};
+
+			int m_iterations = 8;
+
+			//one entry per contact point, rebuilt every step
+			AlignedVector<std::uint32_t> m_bodiesA;
+			AlignedVector<std::uint32_t> m_bodiesB;
+			AlignedVector<glm::vec3> m_normals;
+			AlignedVector<glm::vec3> m_tangents1;
+			AlignedVector<glm::vec3> m_tangents2;
+			AlignedVector<float> m_masses;
+			AlignedVector<float> m_biases;
+			AlignedVector<float> m_frictions;
+			AlignedVector<float> m_normalImpulses;
+			AlignedVector<float> m_tangentImpulses1;
+			AlignedVector<float> m_tangentImpulses2;
+
+			std::vector<ManifoldRange> m_ranges;
+			//grouped by island, and by color within large islands
+			std::vector<Batch> m_tasks;
+			//groups of small islands
+			std::vector<Batch> m_batches;
+			std::vector<ColoredIsland> m_coloredIslands;
+
+			AlignedVector<std::uint64_t> m_bodyColors;
+			std::vector<std::uint32_t> m_manifoldColors;
+			std::vector<std::uint32_t> m_colorOffsets;
+			std::vector<std::uint32_t> m_coloredManifolds;
+
+			std::unordered_map<std::uint64_t, CachedManifold> m_cache;
+
+			void prepare(BodyStorage& bodies, const ContactBuffer& contacts,
+			             const IslandBuilder& islands, float timestep);
+			void addManifold(BodyStorage& bodies, const ContactBuffer& contacts,
+			                 std::uint32_t manifold, float timestep);
+			void colorIsland(BodyStorage& bodies, const ContactBuffer& contacts,
+			                 const Island& island, const IslandBuilder& islands,
+			                 float timestep);
+			void warmStart(BodyStorage& bodies, const Batch& batch);
+			void iterate(BodyStorage& bodies, const Batch& batch);
+			void runBatch(BodyStorage& bodies, const Batch& batch,
+			              ThreadPool& threads, bool warm);
+			void store(const ContactBuffer& contacts);
+	};
+}
+
+#endif //__SOLVER_H__
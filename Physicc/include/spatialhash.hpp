@@ -0,0 +1,87 @@
+#ifndef __SPATIALHASH_H__
+#define __SPATIALHASH_H__
+
+#include "tools/Tracy.hpp"
+
+#include "broadphase.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief Uniform grid broadphase, stored in a spatial hash
+	 *
+	 * Every body is added to all the grid cells its AABB touches, and only
+	 * bodies sharing a cell are tested against each other. The cells live in
+	 * an open addressing hash table keyed on the quantized cell coordinates,
+	 * which is cleared in O(1) and reused every frame.
+	 *
+	 * Works best for swarms of bodies of roughly equal size, with a cell
+	 * size close to the size of a body. Bodies that span too many cells are
+	 * tested against every other body instead.
+	 */
+	class SpatialHash : public Broadphase
+	{
+		public:
+			/**
+			 * @param cellSize Edge length of a grid cell. A size of 0 picks
+			 * the average AABB extent of the bodies every frame.
+			 */
+			SpatialHash(float cellSize = 0.0f);
+
+			[[nodiscard]] inline Type getType() const override
+			{
+				return e_spatialHash;
+			}
+
+			inline void setCellSize(float cellSize)
+			{
+				m_cellSize = cellSize;
+			}
+
+			[[nodiscard]] inline float getCellSize() const
+			{
+				return m_cellSize;
+			}
+
+			void insert(std::size_t body,
+			            const BoundingVolume::AABB& volume) override;
+			void remove(std::size_t body) override;
+			void update(std::size_t body,
+			            const BoundingVolume::AABB& volume) override;
+			void findPairs(std::vector<CollisionPair>& pairs) override;
+
+		private:
+			struct Slot
+			{
+				glm::ivec3 cell;
+				std::uint32_t stamp = 0;
+				std::uint32_t first;
+				//slots whose stamp isn't the current one are empty
+			};
+
+			struct Entry
+			{
+				std::uint32_t body;
+				std::uint32_t next;
+			};
+
+			std::vector<BoundingVolume::AABB> m_volumes;
+			std::vector<bool> m_tracked;
+
+			std::vector<Slot> m_slots;
+			std::vector<std::uint32_t> m_usedSlots;
+			std::vector<Entry> m_entries;
+			std::vector<std::uint32_t> m_large;
+			std::uint32_t m_stamp;
+
+			float m_cellSize;
+
+			float computeCellSize() const;
+			void reserveSlots(std::size_t cellCount);
+			void addToCell(const glm::ivec3& cell, std::uint32_t body);
+	};
+}
+
+#endif //__SPATIALHASH_H__
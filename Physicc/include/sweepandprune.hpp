@@ -0,0 +1,83 @@
+#ifndef __SWEEPANDPRUNE_H__
+#define __SWEEPANDPRUNE_H__
+
+#include "tools/Tracy.hpp"
+
+#include "broadphase.hpp"
+#include "aabbbatch.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief Sort and sweep broadphase
+	 *
+	 * Keeps the interval endpoints of every body on a single axis sorted
+	 * across frames. Since bodies only move a little between frames, the
+	 * endpoints stay almost sorted and an insertion sort restores the order
+	 * in close to linear time. A sweep over the sorted endpoints then only
+	 * tests bodies whose intervals overlap on that axis.
+	 *
+	 * Works best on dense, mostly planar scenes, where the bodies are spread
+	 * out along one dominant axis.
+	 */
+	class SweepAndPrune : public Broadphase
+	{
+		public:
+			SweepAndPrune();
+
+			[[nodiscard]] inline Type getType() const override
+			{
+				return e_sweepAndPrune;
+			}
+
+			void insert(std::size_t body,
+			            const BoundingVolume::AABB& volume) override;
+			void remove(std::size_t body) override;
+			void update(std::size_t body,
+			            const BoundingVolume::AABB& volume) override;
+			void findPairs(std::vector<CollisionPair>& pairs) override;
+
+			[[nodiscard]] inline int getAxis() const
+			{
+				return m_axis;
+			}
+
+		private:
+			struct Endpoint
+			{
+				float value;
+				std::uint32_t body;
+				bool isMin;
+
+				//Lower values go first, and on ties a min endpoint goes
+				//before a max endpoint, so that touching boxes are reported
+				//the same way BoxBV::overlapsWith reports them
+				[[nodiscard]] inline bool operator<(const Endpoint& other) const
+				{
+					return value < other.value
+						|| (value == other.value && isMin && !other.isMin);
+				}
+			};
+
+			std::vector<BoundingVolume::AABB> m_volumes;
+			std::vector<bool> m_tracked;
+			std::vector<Endpoint> m_endpoints;
+
+			std::vector<std::uint32_t> m_active;
+			AABBBatch m_activeVolumes;
+			std::vector<std::uint32_t> m_activeIndex;
+			//scratch buffers for the sweep, kept around to avoid reallocating.
+			//m_activeVolumes[i] is the volume of m_active[i], in SoA form so
+			//a new body is tested against several active ones at once.
+
+			int m_axis;
+			bool m_needsSort;
+
+			int chooseAxis() const;
+			void sortEndpoints();
+	};
+}
+
+#endif //__SWEEPANDPRUNE_H__
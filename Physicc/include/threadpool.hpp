@@ -0,0 +1,102 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include "tools/Tracy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Physicc
+{
+	/**
+	 * @brief A fixed set of worker threads running parallel loops
+	 *
+	 * Unlike std::async, which starts a thread per call, the workers live as
+	 * long as the pool, so that a step can run many short parallel loops
+	 * (one per solver iteration and color) without paying for thread
+	 * creation each time.
+	 */
+	class ThreadPool
+	{
+		public:
+			/**
+			 * @param workerCount Threads started besides the calling thread.
+			 * With 0, every loop runs on the calling thread.
+			 */
+			explicit ThreadPool(std::size_t workerCount = 0);
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+			/**
+			 * @brief Returns the number of threads loops run on, counting
+			 * the calling thread
+			 */
+			[[nodiscard]] inline std::size_t getThreadCount() const
+			{
+				return m_workers.size() + 1;
+			}
+
+			/**
+			 * @brief Calls task(i) for every i in [0, count), spread over the
+			 * workers and the calling thread, and returns once all calls
+			 * are done
+			 *
+			 * Which thread runs which index is unspecified, so tasks must
+			 * not depend on it for their results.
+			 */
+			template <typename Task>
+			void run(std::size_t count, const Task& task)
+			{
+				if (m_workers.empty() || count <= 1)
+				{
+					for (std::size_t i = 0; i < count; i++)
+					{
+						task(i);
+					}
+
+					return;
+				}
+
+				dispatch(count, [](const void* context, std::size_t index)
+				         {
+				         	(*static_cast<const Task*>(context))(index);
+				         }, &task);
+			}
+
+		private:
+			using Function = void (*)(const void*, std::size_t);
+
+			void dispatch(std::size_t count, Function function,
+			              const void* context);
+			void work();
+			std::size_t execute(Function function, const void* context,
+			                    std::size_t count);
+
+			std::vector<std::thread> m_workers;
+
+			std::mutex m_mutex;
+			std::condition_variable m_started;
+			std::condition_variable m_finished;
+			std::uint64_t m_generation = 0;
+			bool m_stopping = false;
+
+			//the loop being run, guarded by m_mutex
+			Function m_function = nullptr;
+			const void* m_context = nullptr;
+			std::size_t m_count = 0;
+			std::size_t m_done = 0;
+			std::size_t m_busy = 0;
+			//workers that took the loop and haven't left it yet
+
+			std::atomic<std::size_t> m_next{0};
+	};
+}
+
+#endif //__THREADPOOL_H__
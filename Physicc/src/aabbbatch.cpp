@@ -0,0 +1,171 @@
+/**
+ * @file aabbbatch.cpp
+ * @brief SoA storage and batched kernels for AABBs.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* aabbbatch header */
+
+#include "tools/Tracy.hpp"
+
+#include "aabbbatch.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Physicc
+{
+	namespace
+	{
+		constexpr float infinity = std::numeric_limits<float>::infinity();
+	}
+
+	void AABBBatch::clear()
+	{
+		//Only the used lanes need to be emptied, the padding already is
+		for (std::size_t i = 0; i < m_size; i++)
+		{
+			setEmpty(i);
+		}
+
+		m_size = 0;
+	}
+
+	void AABBBatch::push_back(const BoundingVolume::AABB& volume)
+	{
+		if (m_size == m_minX.size())
+		{
+			//grow by a whole batch of empty boxes, to keep the padding
+			std::size_t size = m_minX.size() + width;
+			m_minX.resize(size, infinity);
+			m_minY.resize(size, infinity);
+			m_minZ.resize(size, infinity);
+			m_maxX.resize(size, -infinity);
+			m_maxY.resize(size, -infinity);
+			m_maxZ.resize(size, -infinity);
+		}
+
+		set(m_size++, volume);
+	}
+
+	void AABBBatch::set(std::size_t index, const BoundingVolume::AABB& volume)
+	{
+		glm::vec3 lower = volume.getLowerBound();
+		glm::vec3 upper = volume.getUpperBound();
+
+		m_minX[index] = lower.x;
+		m_minY[index] = lower.y;
+		m_minZ[index] = lower.z;
+		m_maxX[index] = upper.x;
+		m_maxY[index] = upper.y;
+		m_maxZ[index] = upper.z;
+	}
+
+	BoundingVolume::AABB AABBBatch::get(std::size_t index) const
+	{
+		return BoundingVolume::AABB(
+			glm::vec3(m_minX[index], m_minY[index], m_minZ[index]),
+			glm::vec3(m_maxX[index], m_maxY[index], m_maxZ[index]));
+	}
+
+	void AABBBatch::swapRemove(std::size_t index)
+	{
+		std::size_t last = --m_size;
+
+		m_minX[index] = m_minX[last];
+		m_minY[index] = m_minY[last];
+		m_minZ[index] = m_minZ[last];
+		m_maxX[index] = m_maxX[last];
+		m_maxY[index] = m_maxY[last];
+		m_maxZ[index] = m_maxZ[last];
+
+		setEmpty(last);
+	}
+
+	void AABBBatch::setEmpty(std::size_t index)
+	{
+		m_minX[index] = m_minY[index] = m_minZ[index] = infinity;
+		m_maxX[index] = m_maxY[index] = m_maxZ[index] = -infinity;
+	}
+
+	BoundingVolume::AABB AABBBatch::enclosingBV() const
+	{
+		ZoneScoped;
+
+		//Empty padding boxes are +inf/-inf, so they drop out of the min/max
+#ifdef PHYSICC_SSE2
+		__m128 minX = _mm_set1_ps(infinity), minY = minX, minZ = minX;
+		__m128 maxX = _mm_set1_ps(-infinity), maxY = maxX, maxZ = maxX;
+
+		for (std::size_t i = 0; i < m_size; i += 4)
+		{
+			minX = _mm_min_ps(minX, _mm_loadu_ps(&m_minX[i]));
+			minY = _mm_min_ps(minY, _mm_loadu_ps(&m_minY[i]));
+			minZ = _mm_min_ps(minZ, _mm_loadu_ps(&m_minZ[i]));
+			maxX = _mm_max_ps(maxX, _mm_loadu_ps(&m_maxX[i]));
+			maxY = _mm_max_ps(maxY, _mm_loadu_ps(&m_maxY[i]));
+			maxZ = _mm_max_ps(maxZ, _mm_loadu_ps(&m_maxZ[i]));
+		}
+
+		alignas(16) float lanes[6][4];
+		_mm_store_ps(lanes[0], minX);
+		_mm_store_ps(lanes[1], minY);
+		_mm_store_ps(lanes[2], minZ);
+		_mm_store_ps(lanes[3], maxX);
+		_mm_store_ps(lanes[4], maxY);
+		_mm_store_ps(lanes[5], maxZ);
+
+		glm::vec3 lower(infinity), upper(-infinity);
+
+		for (int i = 0; i < 4; i++)
+		{
+			lower = glm::min(lower,
+			                 glm::vec3(lanes[0][i], lanes[1][i], lanes[2][i]));
+			upper = glm::max(upper,
+			                 glm::vec3(lanes[3][i], lanes[4][i], lanes[5][i]));
+		}
+#else
+		glm::vec3 lower(infinity), upper(-infinity);
+
+		for (std::size_t i = 0; i < m_size; i++)
+		{
+			lower = glm::min(lower, glm::vec3(m_minX[i], m_minY[i], m_minZ[i]));
+			upper = glm::max(upper, glm::vec3(m_maxX[i], m_maxY[i], m_maxZ[i]));
+		}
+#endif
+
+		return BoundingVolume::AABB(lower, upper);
+	}
+
+	void AABBBatch::getVolumes(std::vector<float>& volumes) const
+	{
+		ZoneScoped;
+
+		volumes.resize(m_size);
+		std::size_t i = 0;
+
+#ifdef PHYSICC_SSE2
+		for (; i + 4 <= m_size; i += 4)
+		{
+			__m128 x = _mm_sub_ps(_mm_loadu_ps(&m_maxX[i]),
+			                      _mm_loadu_ps(&m_minX[i]));
+			__m128 y = _mm_sub_ps(_mm_loadu_ps(&m_maxY[i]),
+			                      _mm_loadu_ps(&m_minY[i]));
+			__m128 z = _mm_sub_ps(_mm_loadu_ps(&m_maxZ[i]),
+			                      _mm_loadu_ps(&m_minZ[i]));
+			_mm_storeu_ps(&volumes[i], _mm_mul_ps(_mm_mul_ps(x, y), z));
+		}
+#endif
+
+		//volumes only has room for size() entries, so the tail is done
+		//one box at a time
+		for (; i < m_size; i++)
+		{
+			volumes[i] = (m_maxX[i] - m_minX[i])
+				* (m_maxY[i] - m_minY[i])
+				* (m_maxZ[i] - m_minZ[i]);
+		}
+	}
+}
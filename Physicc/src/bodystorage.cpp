@@ -0,0 +1,497 @@
+/**
+ * @file bodystorage.cpp
+ * @brief Structure of Arrays storage for rigid bodies, with stable handles.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* bodystorage header */
+
+#include "tools/Tracy.hpp"
+
+#include "bodystorage.hpp"
+
+#include <utility>
+
+namespace Physicc
+{
+	/**
+	 * @brief Calls function with the pool of a shape
+	 */
+	template <typename Function>
+	void BodyStorage::visitPool(Collider::Type type, Function&& function)
+	{
+		switch (type)
+		{
+			case Collider::e_box:
+				function(m_boxes);
+				break;
+			case Collider::e_sphere:
+				function(m_spheres);
+				break;
+			case Collider::e_capsule:
+				function(m_capsules);
+				break;
+			default:
+				function(m_hulls);
+				break;
+		}
+	}
+
+	/**
+	 * @brief Appends a collider to the sleeping end of a pool
+	 */
+	template <typename Shape>
+	std::uint32_t BodyStorage::addCollider(ColliderPool<Shape>& pool,
+	                                       const Shape& collider,
+	                                       std::uint32_t body)
+	{
+		pool.colliders.push_back(collider);
+		pool.bodies.push_back(body);
+
+		return static_cast<std::uint32_t>(pool.colliders.size() - 1);
+	}
+
+	/**
+	 * @brief Exchanges two colliders of a pool, keeping the handles of
+	 * their bodies pointing at them
+	 */
+	template <typename Shape>
+	void BodyStorage::swapColliders(ColliderPool<Shape>& pool,
+	                                std::size_t first, std::size_t second)
+	{
+		if (first == second)
+		{
+			return;
+		}
+
+		std::swap(pool.colliders[first], pool.colliders[second]);
+		std::swap(pool.bodies[first], pool.bodies[second]);
+
+		m_colliders[pool.bodies[first]].index
+			= static_cast<std::uint32_t>(first);
+		m_colliders[pool.bodies[second]].index
+			= static_cast<std::uint32_t>(second);
+	}
+
+	/**
+	 * @brief Moves the collider of the body at a dense index across the
+	 * awake boundary of its pool
+	 *
+	 * Has to be called whenever the body crosses m_awakeCount, so that the
+	 * awake colliders of every pool are those of the awake bodies.
+	 */
+	void BodyStorage::setColliderAwake(std::size_t index, bool awake)
+	{
+		visitPool(m_colliders[index].type, [&](auto& pool)
+		{
+			std::uint32_t collider = m_colliders[index].index;
+
+			if (awake)
+			{
+				swapColliders(pool, collider, pool.awakeCount);
+				pool.awakeCount++;
+			} else
+			{
+				pool.awakeCount--;
+				swapColliders(pool, collider, pool.awakeCount);
+			}
+		});
+	}
+
+	/**
+	 * @brief Points the collider of the body at a dense index back at it,
+	 * after the body has moved
+	 */
+	void BodyStorage::setColliderBody(std::size_t index)
+	{
+		visitPool(m_colliders[index].type, [&](auto& pool)
+		{
+			pool.bodies[m_colliders[index].index]
+				= static_cast<std::uint32_t>(index);
+		});
+	}
+
+	/**
+	 * @brief Updates the awake colliders of a pool
+	 *
+	 * They are at the front of the pool, so this walks
+	 * pool.colliders[0, awakeCount) in order, and scatters the AABBs by
+	 * the dense index of their bodies. The pool holds a single shape, so
+	 * Shape::getAABB() is resolved at compile time, and inlined.
+	 */
+	template <typename Shape>
+	void BodyStorage::updatePool(ColliderPool<Shape>& pool,
+	                             BoundingVolume::AABB* volumes)
+	{
+		for (std::size_t i = 0; i < pool.awakeCount; i++)
+		{
+			std::uint32_t body = pool.bodies[i];
+
+			//moving a collider keeps its cached bounds valid, so this
+			//doesn't recompute anything
+			Shape& collider = pool.colliders[i];
+			collider.setPosition(m_positions[body]);
+			volumes[body] = collider.getAABB();
+		}
+	}
+
+	BodyHandle BodyStorage::add(const RigidBody& body)
+	{
+		PhysiccZoneFine;
+
+		auto dense = static_cast<std::uint32_t>(size());
+		std::uint32_t slot;
+
+		if (m_freeSlot != BodyHandle::nullIndex)
+		{
+			slot = m_freeSlot;
+			m_freeSlot = m_slots[slot].dense;
+			m_slots[slot].dense = dense;
+		} else
+		{
+			slot = static_cast<std::uint32_t>(m_slots.size());
+			m_slots.push_back({dense, 0, BodyHandle::nullIndex});
+		}
+
+		m_slots[slot].nextAsleep = BodyHandle::nullIndex;
+
+		ColliderShape shape = body.getShape();
+		const Collider& copy = shape.get();
+
+		ColliderHandle collider{shape.getType(), 0};
+
+		switch (shape.getType())
+		{
+			case Collider::e_box:
+				collider.index = addCollider(
+					m_boxes, static_cast<const BoxCollider&>(copy), dense);
+				break;
+			case Collider::e_sphere:
+				collider.index = addCollider(
+					m_spheres, static_cast<const SphereCollider&>(copy), dense);
+				break;
+			case Collider::e_capsule:
+				collider.index = addCollider(
+					m_capsules, static_cast<const CapsuleCollider&>(copy),
+					dense);
+				break;
+			default:
+				collider.index = addCollider(
+					m_hulls, static_cast<const ConvexHullCollider&>(copy),
+					dense);
+				break;
+		}
+
+		m_positions.push_back(copy.getPosition());
+		m_previousPositions.push_back(copy.getPosition());
+		m_velocities.push_back(body.getVelocity());
+		m_forces.push_back(body.getForce());
+		m_inverseMasses.push_back(body.getMass() > 0.0f
+		                          ? 1.0f / body.getMass()
+		                          : 0.0f);
+		m_gravityScales.push_back(body.getGravityScale());
+		m_frictions.push_back(body.getFriction());
+		m_restitutions.push_back(body.getRestitution());
+		m_sleepTimes.push_back(0.0f);
+		m_ccdRadii.push_back(body.getCCD() ? getSweptSphereRadius(copy) : 0.0f);
+		m_colliders.push_back(collider);
+		m_slotOf.push_back(slot);
+
+		//new bodies start awake
+		setColliderAwake(dense, true);
+		swapBodies(dense, m_awakeCount);
+		m_awakeCount++;
+
+		return {slot, m_slots[slot].generation};
+	}
+
+	/**
+	 * @brief Removes a body by moving the last body into its place
+	 *
+	 * The slot of the removed body goes on the free list with a new
+	 * generation, so that its old handles stop being valid. The island of
+	 * a sleeping body is woken first, since whatever rested on the body has
+	 * to react to it being gone.
+	 */
+	void BodyStorage::remove(BodyHandle handle)
+	{
+		PhysiccZoneFine;
+
+		wake(handle.index);
+
+		std::uint32_t dense = m_slots[handle.index].dense;
+
+		//move the body to the end of the awake bodies, so that the body
+		//moved into its place below is a sleeping one (or none)
+		swapBodies(dense, m_awakeCount - 1);
+		m_awakeCount--;
+		dense = static_cast<std::uint32_t>(m_awakeCount);
+
+		std::size_t last = size() - 1;
+
+		//the collider goes the same way: past the awake colliders of its
+		//pool, then to the end of the pool, where it is dropped
+		setColliderAwake(dense, false);
+		visitPool(m_colliders[dense].type, [&](auto& pool)
+		{
+			swapColliders(pool, m_colliders[dense].index,
+			              pool.colliders.size() - 1);
+			pool.colliders.pop_back();
+			pool.bodies.pop_back();
+		});
+
+		m_positions[dense] = m_positions[last];
+		m_previousPositions[dense] = m_previousPositions[last];
+		m_velocities[dense] = m_velocities[last];
+		m_forces[dense] = m_forces[last];
+		m_inverseMasses[dense] = m_inverseMasses[last];
+		m_gravityScales[dense] = m_gravityScales[last];
+		m_frictions[dense] = m_frictions[last];
+		m_restitutions[dense] = m_restitutions[last];
+		m_sleepTimes[dense] = m_sleepTimes[last];
+		m_ccdRadii[dense] = m_ccdRadii[last];
+		m_colliders[dense] = m_colliders[last];
+		m_slotOf[dense] = m_slotOf[last];
+		m_slots[m_slotOf[dense]].dense = dense;
+
+		if (dense != last)
+		{
+			setColliderBody(dense);
+		}
+
+		m_positions.pop_back();
+		m_previousPositions.pop_back();
+		m_velocities.pop_back();
+		m_forces.pop_back();
+		m_inverseMasses.pop_back();
+		m_gravityScales.pop_back();
+		m_frictions.pop_back();
+		m_restitutions.pop_back();
+		m_sleepTimes.pop_back();
+		m_ccdRadii.pop_back();
+		m_colliders.pop_back();
+		m_slotOf.pop_back();
+
+		m_slots[handle.index].generation++;
+		m_slots[handle.index].dense = m_freeSlot;
+		m_freeSlot = handle.index;
+	}
+
+	void BodyStorage::clear()
+	{
+		//Free the slots rather than dropping them, so that handles to the
+		//cleared bodies stay invalid once their slots are reused
+		for (auto slot : m_slotOf)
+		{
+			m_slots[slot].generation++;
+			m_slots[slot].nextAsleep = BodyHandle::nullIndex;
+			m_slots[slot].dense = m_freeSlot;
+			m_freeSlot = slot;
+		}
+
+		m_positions.clear();
+		m_previousPositions.clear();
+		m_velocities.clear();
+		m_forces.clear();
+		m_inverseMasses.clear();
+		m_gravityScales.clear();
+		m_frictions.clear();
+		m_restitutions.clear();
+		m_sleepTimes.clear();
+		m_ccdRadii.clear();
+		m_colliders.clear();
+		m_slotOf.clear();
+
+		auto clearPool = [](auto& pool)
+		{
+			pool.colliders.clear();
+			pool.bodies.clear();
+			pool.awakeCount = 0;
+		};
+
+		clearPool(m_boxes);
+		clearPool(m_spheres);
+		clearPool(m_capsules);
+		clearPool(m_hulls);
+		m_awakeCount = 0;
+	}
+
+	void BodyStorage::reserve(std::size_t count, Collider::Type shape)
+	{
+		m_positions.reserve(count);
+		m_previousPositions.reserve(count);
+		m_velocities.reserve(count);
+		m_forces.reserve(count);
+		m_inverseMasses.reserve(count);
+		m_gravityScales.reserve(count);
+		m_frictions.reserve(count);
+		m_restitutions.reserve(count);
+		m_sleepTimes.reserve(count);
+		m_ccdRadii.reserve(count);
+		m_colliders.reserve(count);
+		m_slotOf.reserve(count);
+
+		m_slots.reserve(count);
+
+		auto reservePool = [count](auto& pool)
+		{
+			pool.colliders.reserve(count);
+			pool.bodies.reserve(count);
+		};
+
+		switch (shape)
+		{
+			case Collider::e_box:
+				reservePool(m_boxes);
+				break;
+			case Collider::e_sphere:
+				reservePool(m_spheres);
+				break;
+			case Collider::e_capsule:
+				reservePool(m_capsules);
+				break;
+			default:
+				reservePool(m_hulls);
+				break;
+		}
+	}
+
+	/**
+	 * @brief Runs over the pools one after the other: the awake spheres,
+	 * the awake boxes, and so on
+	 */
+	void BodyStorage::updateColliders(
+		AlignedVector<BoundingVolume::AABB>& volumes)
+	{
+		PhysiccZoneFine;
+
+		volumes.resize(m_awakeCount);
+
+		updatePool(m_spheres, volumes.data());
+		updatePool(m_boxes, volumes.data());
+		updatePool(m_capsules, volumes.data());
+		updatePool(m_hulls, volumes.data());
+	}
+
+	bool BodyStorage::contains(BodyHandle handle) const
+	{
+		//Freeing a slot bumps its generation, and that generation is only
+		//handed out again once the slot is reused, so a matching generation
+		//means the body is alive
+		return handle.index < m_slots.size()
+			&& m_slots[handle.index].generation == handle.generation;
+	}
+
+	void BodyStorage::sleep(const std::uint32_t* slots, std::size_t count)
+	{
+		PhysiccZoneFine;
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::uint32_t first = slots[0];
+		std::uint32_t previous = first;
+
+		for (std::size_t i = 1; i < count; i++)
+		{
+			m_slots[previous].nextAsleep = slots[i];
+			previous = slots[i];
+		}
+
+		m_slots[previous].nextAsleep = first;
+
+		std::uint32_t slot = first;
+
+		do
+		{
+			std::uint32_t dense = m_slots[slot].dense;
+			m_velocities[dense] = glm::vec3(0.0f);
+			m_forces[dense] = glm::vec3(0.0f);
+			m_previousPositions[dense] = m_positions[dense];
+			//so that interpolation doesn't keep a stale position around
+			m_sleepTimes[dense] = 0.0f;
+
+			setColliderAwake(dense, false);
+			swapBodies(dense, m_awakeCount - 1);
+			m_awakeCount--;
+
+			slot = m_slots[slot].nextAsleep;
+		} while (slot != first);
+	}
+
+	void BodyStorage::wake(std::uint32_t slot)
+	{
+		if (m_slots[slot].nextAsleep == BodyHandle::nullIndex)
+		{
+			return;
+		}
+
+		PhysiccZoneFine;
+
+		std::uint32_t current = slot;
+
+		do
+		{
+			std::uint32_t next = m_slots[current].nextAsleep;
+			m_slots[current].nextAsleep = BodyHandle::nullIndex;
+
+			setColliderAwake(m_slots[current].dense, true);
+			swapBodies(m_slots[current].dense, m_awakeCount);
+			m_awakeCount++;
+
+			current = next;
+		} while (current != slot);
+	}
+
+	/**
+	 * @brief Exchanges two bodies in every array, keeping their slots
+	 * pointing at them
+	 */
+	void BodyStorage::swapBodies(std::size_t first, std::size_t second)
+	{
+		if (first == second)
+		{
+			return;
+		}
+
+		std::swap(m_positions[first], m_positions[second]);
+		std::swap(m_previousPositions[first], m_previousPositions[second]);
+		std::swap(m_velocities[first], m_velocities[second]);
+		std::swap(m_forces[first], m_forces[second]);
+		std::swap(m_inverseMasses[first], m_inverseMasses[second]);
+		std::swap(m_gravityScales[first], m_gravityScales[second]);
+		std::swap(m_frictions[first], m_frictions[second]);
+		std::swap(m_restitutions[first], m_restitutions[second]);
+		std::swap(m_sleepTimes[first], m_sleepTimes[second]);
+		std::swap(m_ccdRadii[first], m_ccdRadii[second]);
+		std::swap(m_colliders[first], m_colliders[second]);
+		std::swap(m_slotOf[first], m_slotOf[second]);
+
+		m_slots[m_slotOf[first]].dense = static_cast<std::uint32_t>(first);
+		m_slots[m_slotOf[second]].dense = static_cast<std::uint32_t>(second);
+		setColliderBody(first);
+		setColliderBody(second);
+	}
+
+	RigidBody BodyStorage::getRigidBody(std::size_t index) const
+	{
+		float inverseMass = m_inverseMasses[index];
+		RigidBody body(inverseMass > 0.0f ? 1.0f / inverseMass : 0.0f,
+		               m_velocities[index], m_gravityScales[index]);
+
+		ColliderShape shape = ColliderShape::fromCollider(getCollider(index));
+		shape.get().setPosition(m_positions[index]);
+
+		body.setCollider(shape);
+		body.setForce(m_forces[index]);
+		body.setFriction(m_frictions[index]);
+		body.setRestitution(m_restitutions[index]);
+		body.setCCD(m_ccdRadii[index] > 0.0f);
+
+		return body;
+	}
+}
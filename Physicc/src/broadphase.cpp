@@ -0,0 +1,32 @@
+/**
+ * @file broadphase.cpp
+ * @brief Creates the broadphase algorithms behind the common interface.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* broadphase header */
+
+#include "broadphase.hpp"
+
+#include "dynamictree.hpp"
+#include "spatialhash.hpp"
+#include "sweepandprune.hpp"
+
+namespace Physicc
+{
+	std::unique_ptr<Broadphase> Broadphase::create(Type type)
+	{
+		switch (type)
+		{
+			case e_sweepAndPrune:
+				return std::make_unique<SweepAndPrune>();
+			case e_spatialHash:
+				return std::make_unique<SpatialHash>();
+			case e_dynamicTree:
+			default:
+				return std::make_unique<DynamicTreeBroadphase>();
+		}
+	}
+}
@@ -14,74 +14,311 @@
 
 #include <utility>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <thread>
 
 namespace Physicc
 {
-	BVH::BVH(std::vector<RigidBody> rigidBodyList)
-		: 	m_head(nullptr),
-			m_rigidBodyList(std::move(rigidBodyList)) 
+	namespace
 	{
-	}
+		//Rays cast together are traversed in packets of this many rays, one
+		//bit per ray in a mask
+		constexpr std::size_t packetSize = 8;
 
-	BoundingVolume::AABB BVH::computeBV(std::size_t start, std::size_t end)
-	{
-		ZoneScoped;
+		//16 bins per axis is the usual sweet spot: more bins barely improve
+		//the tree, but make every split more expensive to evaluate
+		constexpr std::size_t binCount = 16;
 
-		BoundingVolume::AABB bv(m_rigidBodyList[start].getAABB());
+		struct SAHBin
+		{
+			BoundingVolume::AABB volume{glm::vec3(0.0f), glm::vec3(0.0f)};
+			std::size_t count = 0;
+			//volume is only meaningful once count != 0
+		};
+
+		inline std::size_t binIndex(float centroid, float min, float scale)
+		{
+			auto bin = static_cast<std::size_t>((centroid - min) * scale);
+			return std::min(bin, binCount - 1);
+		}
+
+		//Subtrees (and reductions) smaller than this are not worth the cost
+		//of spawning a task for
+		constexpr std::size_t taskThreshold = 4096;
+		constexpr std::size_t reductionGrain = 16384;
+
+		inline std::size_t workerCount()
+		{
+			return std::max(1u, std::thread::hardware_concurrency());
+		}
 
-		for (std::size_t i = start + 1; i != end; i++)
+		/**
+		 * @brief Reduces [start, end) on several threads
+		 *
+		 * The range is cut into equal chunks, every chunk but the first is
+		 * reduced by its own task, and the partial results are combined in
+		 * chunk order, so the result does not depend on scheduling.
+		 */
+		template <typename Reduce, typename Combine>
+		auto parallelReduce(std::size_t start, std::size_t end,
+		                    Reduce reduce, Combine combine)
 		{
-			bv = BoundingVolume::enclosingBV(bv, m_rigidBodyList[i].getAABB());
-			//TODO: Object slicing is might be happening here. Investigate.
+			std::size_t taskCount = std::min(workerCount(),
+			                                 (end - start) / reductionGrain);
+
+			if (taskCount < 2)
+			{
+				return reduce(start, end);
+			}
+
+			std::size_t chunk = (end - start) / taskCount;
+			std::vector<std::future<decltype(reduce(start, end))>> partials;
+			partials.reserve(taskCount - 1);
+
+			for (std::size_t task = 1; task < taskCount; task++)
+			{
+				std::size_t chunkStart = start + task * chunk;
+				std::size_t chunkEnd = (task == taskCount - 1)
+					? end
+					: chunkStart + chunk;
+
+				partials.push_back(std::async(std::launch::async, reduce,
+				                              chunkStart, chunkEnd));
+			}
+
+			auto result = reduce(start, start + chunk);
+
+			for (auto& partial : partials)
+			{
+				result = combine(result, partial.get());
+			}
+
+			return result;
 		}
 
-		return bv;
+		/**
+		 * @brief Runs body(first, last) over chunks of [start, end) on
+		 * several threads, and returns once every chunk is done
+		 */
+		template <typename Body>
+		void parallelFor(std::size_t start, std::size_t end, Body body)
+		{
+			std::size_t taskCount = std::min(workerCount(),
+			                                 (end - start) / reductionGrain);
+
+			if (taskCount < 2)
+			{
+				body(start, end);
+				return;
+			}
+
+			std::size_t chunk = (end - start) / taskCount;
+			std::vector<std::future<void>> tasks;
+			tasks.reserve(taskCount - 1);
+
+			for (std::size_t task = 1; task < taskCount; task++)
+			{
+				std::size_t chunkStart = start + task * chunk;
+				std::size_t chunkEnd = (task == taskCount - 1)
+					? end
+					: chunkStart + chunk;
+
+				tasks.push_back(std::async(std::launch::async, body,
+				                           chunkStart, chunkEnd));
+			}
+
+			body(start, start + chunk);
+
+			for (auto& task : tasks)
+			{
+				task.get();
+			}
+		}
+
+		//Morton codes interleave 21 bits per axis, the most that fit in 64
+		constexpr int mortonBits = 21;
+		constexpr std::uint32_t mortonCells = 1u << mortonBits;
+
+		/**
+		 * @brief Spreads the low 21 bits of value out to every third bit
+		 */
+		inline std::uint64_t expandBits(std::uint32_t value)
+		{
+			std::uint64_t x = value & (mortonCells - 1);
+			x = (x | x << 32) & 0x1f00000000ffffull;
+			x = (x | x << 16) & 0x1f0000ff0000ffull;
+			x = (x | x << 8) & 0x100f00f00f00f00full;
+			x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+			x = (x | x << 2) & 0x1249249249249249ull;
+
+			return x;
+		}
+
+		//Radix sort digits: 8 passes of 8 bits cover the 63 bit codes
+		constexpr int radixBits = 8;
+		constexpr std::size_t radixSize = std::size_t(1) << radixBits;
+		constexpr int radixPasses =
+			(3 * mortonBits + radixBits - 1) / radixBits;
+
+		/**
+		 * @brief Sorts keys by code, with a least significant digit first
+		 * radix sort
+		 *
+		 * The histograms of every digit are counted in a single pass, and
+		 * digits that are the same for every key (e.g. the high bits, when
+		 * there are few keys) are skipped. The sort is stable, so equal
+		 * codes keep their order, and the result is deterministic.
+		 */
+		template <typename Key>
+		void radixSort(std::vector<Key>& keys, std::vector<Key>& scratch)
+		{
+			std::vector<std::uint32_t> counts(radixPasses * radixSize, 0);
+
+			for (const auto& key : keys)
+			{
+				for (int pass = 0; pass < radixPasses; pass++)
+				{
+					std::size_t digit = (key.code >> (pass * radixBits)) &
+					                    (radixSize - 1);
+					counts[pass * radixSize + digit]++;
+				}
+			}
+
+			scratch.resize(keys.size());
+
+			for (int pass = 0; pass < radixPasses; pass++)
+			{
+				std::uint32_t* count = &counts[pass * radixSize];
+				std::size_t digit = (keys.front().code >> (pass * radixBits)) &
+				                    (radixSize - 1);
+
+				if (count[digit] == keys.size())
+				{
+					continue;
+				}
+
+				std::uint32_t offset = 0;
+
+				for (std::size_t i = 0; i < radixSize; i++)
+				{
+					std::uint32_t size = count[i];
+					count[i] = offset;
+					offset += size;
+				}
+				//the counts become the first position of every digit
+
+				for (const auto& key : keys)
+				{
+					scratch[count[(key.code >> (pass * radixBits)) &
+					              (radixSize - 1)]++] = key;
+				}
+
+				keys.swap(scratch);
+			}
+		}
+
+		//Treelets are grown to 7 leaves, which is where the quality gained
+		//stops paying for the 3^7 partitions to evaluate
+		constexpr std::size_t treeletLeaves = 7;
+		constexpr std::size_t treeletSubsets = std::size_t(1) << treeletLeaves;
+
+		inline void grow(SAHBin& bin, const BoundingVolume::AABB& volume)
+		{
+			bin.volume = bin.count == 0
+				? volume
+				: BoundingVolume::enclosingBV(bin.volume, volume);
+			bin.count++;
+		}
+
+		inline void grow(SAHBin& bin, const SAHBin& other)
+		{
+			if (other.count != 0)
+			{
+				bin.volume = bin.count == 0
+					? other.volume
+					: BoundingVolume::enclosingBV(bin.volume, other.volume);
+				bin.count += other.count;
+			}
+		}
+	}
+
+	BVH::BVH(std::vector<RigidBody> rigidBodyList, Builder builder,
+	         float rebuildThreshold)
+		: 	m_rigidBodyList(std::move(rigidBodyList)),
+			m_builder(builder),
+			m_rebuildThreshold(rebuildThreshold)
+	{
+	}
+
+	BoundingVolume::AABB BVH::computeBV(std::size_t start,
+	                                    std::size_t end) const
+	{
+		PhysiccZoneFine;
+
+		return parallelReduce(start, end,
+			[this](std::size_t first, std::size_t last) {
+				BoundingVolume::AABB bv(m_primitives[first].volume);
+
+				for (std::size_t i = first + 1; i != last; i++)
+				{
+					bv = BoundingVolume::enclosingBV(bv,
+					                                 m_primitives[i].volume);
+				}
+
+				return bv;
+			},
+			[](const BoundingVolume::AABB& bv1,
+			   const BoundingVolume::AABB& bv2) {
+				return BoundingVolume::enclosingBV(bv1, bv2);
+			});
+	}
+
+	BVImpl::AABB BVH::computeCentroidBounds(std::size_t start,
+	                                        std::size_t end) const
+	{
+		return parallelReduce(start, end,
+			[this](std::size_t first, std::size_t last) {
+				BVImpl::AABB bounds(m_primitives[first].centroid,
+				                    m_primitives[first].centroid);
+
+				for (std::size_t i = first + 1; i != last; i++)
+				{
+					const auto& centroid = m_primitives[i].centroid;
+					bounds.lowerBound = glm::min(bounds.lowerBound, centroid);
+					bounds.upperBound = glm::max(bounds.upperBound, centroid);
+				}
+
+				return bounds;
+			},
+			[](const BVImpl::AABB& bounds1, const BVImpl::AABB& bounds2) {
+				return BVImpl::AABB(
+					glm::min(bounds1.lowerBound, bounds2.lowerBound),
+					glm::max(bounds1.upperBound, bounds2.upperBound));
+			});
+		//min and max are exact, so the result is the same no matter how the
+		//range was chunked
 	}
 
 	void BVH::sort(Axis axis, std::size_t start, std::size_t end)
 	{
-		if (axis == X)
-		{
-			std::sort(std::next(m_rigidBodyList.begin(), start),
-			          std::next(m_rigidBodyList.begin(), end),
-			          [](const RigidBody& rigidBody1,
-			             const RigidBody& rigidBody2) {
-			            return rigidBody1.getCentroid().x
-				            > rigidBody2.getCentroid().x;
-			          });
-		} else if (axis == Y)
-		{
-			std::sort(std::next(m_rigidBodyList.begin(), start),
-			          std::next(m_rigidBodyList.begin(), end),
-			          [](const RigidBody& rigidBody1,
-			             const RigidBody& rigidBody2) {
-			            return rigidBody1.getCentroid().y
-				            > rigidBody2.getCentroid().y;
-			          });
-		} else
-		{
-			std::sort(std::next(m_rigidBodyList.begin(), start),
-			          std::next(m_rigidBodyList.begin(), end),
-			          [](const RigidBody& rigidBody1,
-			             const RigidBody& rigidBody2) {
-			            return rigidBody1.getCentroid().y
-				            > rigidBody2.getCentroid().y;
-			          });
-		}
+		std::sort(std::next(m_primitives.begin(), start),
+		          std::next(m_primitives.begin(), end),
+		          [axis](const Primitive& primitive1,
+		                 const Primitive& primitive2) {
+		            return primitive1.centroid[axis]
+		                > primitive2.centroid[axis];
+		          });
 	}
 
 	BVH::Axis BVH::getMedianCuttingAxis(std::size_t start, std::size_t end)
 	{
 		//TODO: Suggest a better name
-    
-		glm::vec3 min(m_rigidBodyList[start].getCentroid()),
-			max(m_rigidBodyList[start].getCentroid());
 
-		for (std::size_t i = start + 1; i <= end; i++)
-		{
-			min = glm::min(min, m_rigidBodyList[i].getCentroid());
-			max = glm::max(max, m_rigidBodyList[i].getCentroid());
-		}
+		auto bounds = computeCentroidBounds(start, end);
+		glm::vec3 min = bounds.lowerBound, max = bounds.upperBound;
 
 		float x_spread = max.x - min.x, y_spread = max.y - min.y,
 			z_spread = max.z - min.z;
@@ -98,45 +335,989 @@ namespace Physicc
 		}
 	}
 
-	inline void BVH::buildTree()
+	std::size_t BVH::splitMedian(std::size_t start, std::size_t end)
+	{
+		sort(getMedianCuttingAxis(start, end), start, end);
+
+		return start + (end - start + 1) / 2;
+	}
+
+	/**
+	 * @brief Partitions [start, end) with the binned Surface Area Heuristic
+	 *
+	 * The centroids are binned along each axis, and the cost of every split
+	 * plane between two bins is evaluated as
+	 * leftCount * leftArea + rightCount * rightArea. The bodies are then
+	 * partitioned around the cheapest plane in O(n), without sorting.
+	 * Falls back to the median split when all centroids coincide.
+	 *
+	 * @return The index of the first body of the right child
+	 */
+	std::size_t BVH::splitBinnedSAH(std::size_t start, std::size_t end)
+	{
+		auto bounds = computeCentroidBounds(start, end);
+		glm::vec3 min = bounds.lowerBound, max = bounds.upperBound;
+
+		glm::vec3 scale(0.0f);
+		//an axis along which every centroid coincides has a scale of 0 and
+		//is skipped, as it cannot be split
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = max[axis] - min[axis];
+
+			if (extent > 0.0f)
+			{
+				scale[axis] = static_cast<float>(binCount) / extent;
+			}
+		}
+
+		//Bin all three axes in a single pass, so each primitive is only read
+		//once per level
+		std::array<std::array<SAHBin, binCount>, 3> bins;
+
+		for (std::size_t i = start; i != end; i++)
+		{
+			const auto& volume = m_primitives[i].volume;
+			const auto& centroid = m_primitives[i].centroid;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (scale[axis] != 0.0f)
+				{
+					grow(bins[axis][binIndex(centroid[axis], min[axis],
+					                         scale[axis])], volume);
+				}
+			}
+		}
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis = -1;
+		std::size_t bestSplit = 0;
+		//bins [0, bestSplit] go left, the rest go right
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (scale[axis] == 0.0f)
+			{
+				continue;
+			}
+
+			//Sweep from the right to get the cost of every right-hand side,
+			//then from the left to combine it with the left-hand sides.
+			std::array<float, binCount - 1> rightCost;
+			SAHBin accumulated;
+
+			for (std::size_t i = binCount - 1; i > 0; i--)
+			{
+				grow(accumulated, bins[axis][i]);
+
+				rightCost[i - 1] = static_cast<float>(accumulated.count)
+					* accumulated.volume.getSurfaceArea();
+			}
+
+			accumulated = SAHBin();
+
+			for (std::size_t i = 0; i < binCount - 1; i++)
+			{
+				grow(accumulated, bins[axis][i]);
+
+				if (accumulated.count == 0
+				    || accumulated.count == end - start)
+				{
+					continue;
+				}
+				//an empty side is not a split at all
+
+				float cost = static_cast<float>(accumulated.count)
+					* accumulated.volume.getSurfaceArea() + rightCost[i];
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+			}
+		}
+
+		if (bestAxis == -1)
+		{
+			return splitMedian(start, end);
+		}
+
+		float axisMin = min[bestAxis];
+		float axisScale = scale[bestAxis];
+		auto goesLeft = [&](const Primitive& primitive) {
+			return binIndex(primitive.centroid[bestAxis], axisMin, axisScale)
+				<= bestSplit;
+		};
+		auto mid = std::partition(std::next(m_primitives.begin(), start),
+		                          std::next(m_primitives.begin(), end),
+		                          goesLeft);
+
+		return static_cast<std::size_t>(
+			std::distance(m_primitives.begin(), mid));
+	}
+
+	void BVH::buildTree()
 	{
-		buildTree(m_head, 0, m_rigidBodyList.size() - 1);
+		ZoneScoped;
+
+		m_nodes.clear();
+		m_buildCost = m_cost = 0.0f;
+
+		if (m_rigidBodyList.empty())
+		{
+			return;
+		}
+
+		//a binary tree with n leaves has exactly 2n - 1 nodes, so the whole
+		//node pool can be laid out before any subtree is built
+		m_nodes.resize(2 * m_rigidBodyList.size() - 1);
+
+		m_primitives.resize(m_rigidBodyList.size());
+
+		for (std::size_t i = 0; i < m_rigidBodyList.size(); i++)
+		{
+			m_primitives[i] = {m_rigidBodyList[i].getAABB(),
+			                   m_rigidBodyList[i].getCentroid(),
+			                   static_cast<std::uint32_t>(i)};
+		}
+
+		//Every level of task spawning doubles the number of concurrently
+		//built subtrees, so stop spawning once all workers are busy
+		unsigned int taskDepth = 0;
+
+		while ((std::size_t(1) << taskDepth) < workerCount())
+		{
+			taskDepth++;
+		}
+
+		if (m_builder == e_lbvh)
+		{
+			buildMorton(taskDepth);
+		} else
+		{
+			buildTree(0, 0, m_rigidBodyList.size(), taskDepth);
+		}
+
+		if (m_restructure)
+		{
+			restructure(taskDepth);
+		}
+
+		//leaves refer to bodies by their position in the list, so put the
+		//bodies in the order the build left the primitives in
+		m_reorderedBodies.clear();
+		m_reorderedBodies.reserve(m_rigidBodyList.size());
+
+		for (const auto& primitive : m_primitives)
+		{
+			m_reorderedBodies.push_back(
+				std::move(m_rigidBodyList[primitive.body]));
+		}
+
+		m_rigidBodyList.swap(m_reorderedBodies);
+		m_reorderedBodies.clear();
+
+		m_buildCost = m_cost = computeCost();
 	}
 
-	void BVH::buildTree(BVHNode* node, std::size_t start, std::size_t end)
+	float BVH::computeCost() const
+	{
+		float cost = 0.0f;
+
+		for (const auto& node : m_nodes)
+		{
+			if (!node.isLeaf())
+			{
+				cost += node.volume.getSurfaceArea();
+			}
+		}
+
+		return cost;
+	}
+
+	/**
+	 * @brief Recomputes every bounding volume without changing the topology
+	 *
+	 * Children are always stored after their parent, so walking the node
+	 * array backwards visits every node after both of its children, and the
+	 * whole refit is a single O(n) pass with no recursion.
+	 */
+	void BVH::refit()
 	{
 		ZoneScoped;
 
-		//implicit convention:
-		//no children = leaf node
-		//no parent = head node
+		for (std::size_t i = m_nodes.size(); i-- != 0;)
+		{
+			auto& node = m_nodes[i];
+
+			if (node.isLeaf())
+			{
+				node.volume = m_rigidBodyList[node.body].getAABB();
+			} else
+			{
+				node.volume = BoundingVolume::enclosingBV(
+					m_nodes[i + 1].volume, m_nodes[node.right].volume);
+			}
+		}
+
+		m_cost = computeCost();
+	}
+
+	bool BVH::update()
+	{
+		ZoneScoped;
+
+		refit();
+
+		if (getQuality() > m_rebuildThreshold)
+		{
+			buildTree();
+			return true;
+		}
+
+		return false;
+	}
 
-		//All nodes are equal to nullptr until they are explicitly assigned
-		//non-null values
+	void BVH::buildTree(std::size_t index, std::size_t start, std::size_t end,
+	                    unsigned int taskDepth)
+	{
+		//[start, end) is the slice of m_primitives that this node covers.
+		//Nodes are laid out in depth-first order: the left child is always
+		//placed right after its parent, and the right child after the whole
+		//left subtree. A subtree over k bodies has exactly 2k - 1 nodes, so
+		//the index of the right child is known before the left subtree is
+		//built, and both subtrees can be built independently.
 
-		if (start == end)
+		if (end - start == 1)
 		{
 			//then the only element left in this sliced vector is the one at
 			//`start`
-			node->volume = m_rigidBodyList[start].getAABB();
-			node->body = &m_rigidBodyList[start];
+			m_nodes[index].volume = m_primitives[start].volume;
+			m_nodes[index].body = static_cast<std::uint32_t>(start);
+			return;
+		}
+
+		m_nodes[index].volume = computeBV(start, end);
+
+		std::size_t mid = (m_builder == e_binnedSAH)
+			? splitBinnedSAH(start, end)
+			: splitMedian(start, end);
+
+		std::size_t left = index + 1;
+		std::size_t right = index + 2 * (mid - start);
+
+		m_nodes[index].right = static_cast<std::uint32_t>(right);
+
+		if (taskDepth != 0 && end - start >= taskThreshold)
+		{
+			ZoneScopedN("BVH::buildTree task");
+
+			//The two subtrees touch disjoint slices of both m_primitives and
+			//m_nodes, so they can be built concurrently without locking,
+			//and the result is identical to the serial build
+			auto leftTask = std::async(std::launch::async,
+				[this, left, start, mid, taskDepth] {
+					buildTree(left, start, mid, taskDepth - 1);
+				});
+
+			buildTree(right, mid, end, taskDepth - 1);
+			leftTask.get();
+		} else
+		{
+			buildTree(left, start, mid, 0);
+			buildTree(right, mid, end, 0);
+		}
+	}
+
+	/**
+	 * @brief Builds a linear BVH over m_primitives
+	 *
+	 * The centroids are quantized to a 2^21 grid over their bounds, and
+	 * their coordinates interleaved into 63 bit Morton codes. Sorting the
+	 * primitives by code lays them out along a Z-order curve, on which
+	 * primitives close in space end up close together, and every subtree
+	 * is then a range of that order.
+	 */
+	void BVH::buildMorton(unsigned int taskDepth)
+	{
+		ZoneScopedN("BVH::buildMorton");
+
+		std::size_t count = m_primitives.size();
+		auto bounds = computeCentroidBounds(0, count);
+		glm::vec3 min = bounds.lowerBound;
+		glm::vec3 scale(0.0f);
+		//axes along which every centroid coincides get a scale of 0, so
+		//all their cells are 0
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = bounds.upperBound[axis] - min[axis];
+
+			if (extent > 0.0f)
+			{
+				scale[axis] = static_cast<float>(mortonCells) / extent;
+			}
+		}
+
+		m_mortonKeys.resize(count);
+
+		parallelFor(0, count, [this, min, scale](std::size_t first,
+		                                         std::size_t last) {
+			for (std::size_t i = first; i != last; i++)
+			{
+				glm::vec3 cell = (m_primitives[i].centroid - min) * scale;
+				std::uint64_t code = 0;
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					auto coordinate = static_cast<std::uint32_t>(std::min(
+						cell[axis], static_cast<float>(mortonCells - 1)));
+					code |= expandBits(coordinate) << (2 - axis);
+				}
+
+				m_mortonKeys[i] = {code, static_cast<std::uint32_t>(i)};
+			}
+		});
+
+		radixSort(m_mortonKeys, m_mortonScratch);
+
+		m_sortedPrimitives.resize(count);
+
+		parallelFor(0, count, [this](std::size_t first, std::size_t last) {
+			for (std::size_t i = first; i != last; i++)
+			{
+				m_sortedPrimitives[i] = m_primitives[m_mortonKeys[i].primitive];
+			}
+		});
+
+		m_primitives.swap(m_sortedPrimitives);
+
+		buildMorton(0, 0, count, taskDepth);
+	}
+
+	/**
+	 * @brief Builds the subtree over [start, end) of the sorted primitives
+	 *
+	 * Splitting only needs the codes, so the topology is laid out top down
+	 * exactly like buildTree(index, ...) does, with subtrees built as
+	 * parallel tasks. The volumes are then filled in bottom up, as the
+	 * union of the children's, instead of from every primitive of the
+	 * range.
+	 */
+	void BVH::buildMorton(std::size_t index, std::size_t start,
+	                      std::size_t end, unsigned int taskDepth)
+	{
+		if (end - start == 1)
+		{
+			m_nodes[index].volume = m_primitives[start].volume;
+			m_nodes[index].body = static_cast<std::uint32_t>(start);
+			return;
+		}
+
+		std::size_t mid = splitMorton(start, end);
+		std::size_t left = index + 1;
+		std::size_t right = index + 2 * (mid - start);
+
+		m_nodes[index].right = static_cast<std::uint32_t>(right);
+
+		if (taskDepth != 0 && end - start >= taskThreshold)
+		{
+			auto leftTask = std::async(std::launch::async,
+				[this, left, start, mid, taskDepth] {
+					buildMorton(left, start, mid, taskDepth - 1);
+				});
+
+			buildMorton(right, mid, end, taskDepth - 1);
+			leftTask.get();
 		} else
 		{
-			node->volume = BoundingVolume::AABB(computeBV(start, end));
+			buildMorton(left, start, mid, 0);
+			buildMorton(right, mid, end, 0);
+		}
+
+		m_nodes[index].volume = BoundingVolume::enclosingBV(
+			m_nodes[left].volume, m_nodes[right].volume);
+	}
+
+	std::size_t BVH::splitMorton(std::size_t start, std::size_t end) const
+	{
+		std::uint64_t first = m_mortonKeys[start].code;
+		std::uint64_t last = m_mortonKeys[end - 1].code;
+
+		if (first == last)
+		{
+			return start + (end - start) / 2;
+		}
+		//primitives in the same cell can't be told apart, so they are just
+		//cut in half
+
+		std::uint64_t differing = first ^ last;
+		differing |= differing >> 1;
+		differing |= differing >> 2;
+		differing |= differing >> 4;
+		differing |= differing >> 8;
+		differing |= differing >> 16;
+		differing |= differing >> 32;
+		std::uint64_t highest = differing ^ (differing >> 1);
+
+		//the codes are sorted and share every bit above the highest
+		//differing one, so the right child starts at the first code with
+		//that bit set
+		std::uint64_t split = last & ~(highest - 1);
+
+		auto codeLess = [](const MortonKey& key, std::uint64_t code) {
+			return key.code < code;
+		};
+		auto mid = std::lower_bound(std::next(m_mortonKeys.begin(), start),
+		                            std::next(m_mortonKeys.begin(), end),
+		                            split, codeLess);
+
+		return static_cast<std::size_t>(
+			std::distance(m_mortonKeys.begin(), mid));
+	}
+
+	/**
+	 * @brief Restructures the treelets of the whole tree, then lays the
+	 * tree out depth first again
+	 *
+	 * Based on "Fast Parallel Construction of High-Quality Bounding Volume
+	 * Hierarchies" (Karras and Aila, 2013), with a single bottom-up pass.
+	 */
+	void BVH::restructure(unsigned int taskDepth)
+	{
+		ZoneScopedN("BVH::restructure");
+
+		m_treeletNodes.resize(m_nodes.size());
+		restructure(0, m_nodes.size(), taskDepth);
+		flatten();
+	}
+
+	/**
+	 * @brief Restructures the subtree laid out in [index, end) of m_nodes
+	 *
+	 * Children always come after their parent, so walking the range
+	 * backwards handles every node after all of its descendants, like
+	 * refit() does. Subtrees only ever reuse nodes of their own range, so
+	 * disjoint subtrees can be restructured in parallel.
+	 */
+	void BVH::restructure(std::size_t index, std::size_t end,
+	                      unsigned int taskDepth)
+	{
+		const auto& node = m_nodes[index];
+
+		if (taskDepth != 0 && end - index >= 2 * taskThreshold &&
+		    !node.isLeaf())
+		{
+			std::size_t left = index + 1;
+			std::size_t right = node.right;
+
+			auto leftTask = std::async(std::launch::async,
+				[this, left, right, taskDepth] {
+					restructure(left, right, taskDepth - 1);
+				});
+
+			restructure(right, end, taskDepth - 1);
+			leftTask.get();
+
+			initTreeletNode(index);
+			optimizeTreelet(index);
+			return;
+		}
+
+		for (std::size_t i = end; i-- != index;)
+		{
+			initTreeletNode(i);
+
+			if (m_treeletNodes[i].leafCount >= treeletLeaves)
+			{
+				optimizeTreelet(i);
+			}
+		}
+	}
+
+	void BVH::initTreeletNode(std::size_t index)
+	{
+		const auto& node = m_nodes[index];
+		auto& treeletNode = m_treeletNodes[index];
+
+		if (node.isLeaf())
+		{
+			treeletNode = {BVHNode::nullIndex, BVHNode::nullIndex, 1, 0.0f};
+			return;
+		}
+
+		const auto& left = m_treeletNodes[index + 1];
+		const auto& right = m_treeletNodes[node.right];
+
+		treeletNode = {static_cast<std::uint32_t>(index + 1), node.right,
+		               left.leafCount + right.leafCount,
+		               node.volume.getSurfaceArea() + left.cost + right.cost};
+	}
+
+	/**
+	 * @brief Replaces the treelet rooted at index with the best one over
+	 * the same leaves
+	 *
+	 * The treelet is grown from the node by repeatedly opening its
+	 * largest internal leaf, until it has 7 leaves. The cost of the best
+	 * tree over every subset of those leaves is then found by dynamic
+	 * programming, from the smallest subsets up, trying every way to cut a
+	 * subset in two. If the best tree over all 7 beats the current one,
+	 * the treelet's internal nodes are rewired into it.
+	 */
+	void BVH::optimizeTreelet(std::size_t index)
+	{
+		std::array<std::uint32_t, treeletLeaves> leaves;
+		std::array<std::uint32_t, treeletLeaves - 1> internals;
+		std::size_t leafCount = 2;
+		std::size_t internalCount = 1;
+
+		internals[0] = static_cast<std::uint32_t>(index);
+		leaves[0] = m_treeletNodes[index].left;
+		leaves[1] = m_treeletNodes[index].right;
+
+		while (leafCount < treeletLeaves)
+		{
+			std::size_t largest = treeletLeaves;
+			float largestArea = -1.0f;
+
+			for (std::size_t i = 0; i < leafCount; i++)
+			{
+				float area = m_nodes[leaves[i]].volume.getSurfaceArea();
+
+				if (m_treeletNodes[leaves[i]].left != BVHNode::nullIndex &&
+				    area > largestArea)
+				{
+					largest = i;
+					largestArea = area;
+				}
+			}
+
+			const auto& opened = m_treeletNodes[leaves[largest]];
+			internals[internalCount++] = leaves[largest];
+			leaves[leafCount++] = opened.right;
+			leaves[largest] = opened.left;
+		}
+		//a node with at least 7 leaves always has an internal treelet
+		//leaf left to open
+
+		std::array<BoundingVolume::AABB, treeletSubsets> volumes;
+		std::array<float, treeletSubsets> costs;
+		std::array<std::uint32_t, treeletSubsets> leafCounts;
+		std::array<std::uint8_t, treeletSubsets> splits;
+
+		for (std::size_t subset = 1; subset < treeletSubsets; subset++)
+		{
+			std::size_t lowest = subset & (~subset + 1);
+			std::size_t rest = subset ^ lowest;
+			std::size_t leaf = 0;
+
+			while ((std::size_t(1) << leaf) != lowest)
+			{
+				leaf++;
+			}
+
+			if (rest == 0)
+			{
+				volumes[subset] = m_nodes[leaves[leaf]].volume;
+				costs[subset] = m_treeletNodes[leaves[leaf]].cost;
+				leafCounts[subset] = m_treeletNodes[leaves[leaf]].leafCount;
+				continue;
+			}
+
+			volumes[subset] = BoundingVolume::enclosingBV(
+				volumes[rest], m_nodes[leaves[leaf]].volume);
+			leafCounts[subset] = leafCounts[rest] + leafCounts[lowest];
+
+			//only the cuts that put the lowest leaf on the left, since the
+			//other half are the same cuts mirrored
+			float best = std::numeric_limits<float>::max();
+
+			for (std::size_t part = (subset - 1) & subset; part != 0;
+			     part = (part - 1) & subset)
+			{
+				if ((part & lowest) == 0)
+				{
+					continue;
+				}
+
+				float cost = costs[part] + costs[subset ^ part];
+
+				if (cost < best)
+				{
+					best = cost;
+					splits[subset] = static_cast<std::uint8_t>(part);
+				}
+			}
+
+			costs[subset] = volumes[subset].getSurfaceArea() + best;
+		}
+
+		std::size_t all = treeletSubsets - 1;
+
+		if (costs[all] >= m_treeletNodes[index].cost)
+		{
+			return;
+		}
+
+		//Rewire top down: every subset of two leaves or more becomes one
+		//of the treelet's internal nodes, the root keeping its place
+		std::array<std::pair<std::size_t, std::uint32_t>, treeletLeaves - 1>
+			stack;
+		std::size_t stackSize = 0;
+		std::size_t nextInternal = 1;
+		stack[stackSize++] = {all, static_cast<std::uint32_t>(index)};
+
+		auto getChild = [&](std::size_t part) {
+			if ((part & (part - 1)) == 0)
+			{
+				std::size_t leaf = 0;
+
+				while ((std::size_t(1) << leaf) != part)
+				{
+					leaf++;
+				}
+
+				return leaves[leaf];
+			}
+
+			std::uint32_t child = internals[nextInternal++];
+			stack[stackSize++] = {part, child};
+			return child;
+		};
+
+		while (stackSize != 0)
+		{
+			auto [subset, node] = stack[--stackSize];
+			std::uint32_t left = getChild(splits[subset]);
+			std::uint32_t right = getChild(subset ^ splits[subset]);
+
+			m_nodes[node].volume = volumes[subset];
+			m_treeletNodes[node] = {left, right, leafCounts[subset],
+			                        costs[subset]};
+			//the internal children are rewired after their parent, so
+			//their leaf counts can't be read back from them yet
+		}
+	}
+
+	/**
+	 * @brief Lays the restructured tree out depth first in m_nodes again,
+	 * and reorders the primitives to match the new order of the leaves
+	 */
+	void BVH::flatten()
+	{
+		m_flatNodes.resize(m_nodes.size());
+		m_sortedPrimitives.resize(m_primitives.size());
+
+		std::uint32_t nextLeaf = 0;
+		m_pairStack.clear();
+		m_pairStack.emplace_back(0, 0);
+		//(node in m_nodes, its place in m_flatNodes)
+
+		while (!m_pairStack.empty())
+		{
+			auto [index, flatIndex] = m_pairStack.back();
+			m_pairStack.pop_back();
+
+			const auto& treeletNode = m_treeletNodes[index];
+			auto& flatNode = m_flatNodes[flatIndex];
+			flatNode.volume = m_nodes[index].volume;
 
-			sort(getMedianCuttingAxis(start, end), start, end);
+			if (treeletNode.left == BVHNode::nullIndex)
+			{
+				m_sortedPrimitives[nextLeaf] =
+					m_primitives[m_nodes[index].body];
+				flatNode.body = nextLeaf++;
+				flatNode.right = BVHNode::nullIndex;
+				continue;
+			}
 
-			auto leftNode = new BVHNode;
-			auto rightNode = new BVHNode;
+			flatNode.body = BVHNode::nullIndex;
+			flatNode.right = flatIndex +
+			                 2 * m_treeletNodes[treeletNode.left].leafCount;
 
-			node->left = leftNode;
-			node->right = rightNode;
+			m_pairStack.emplace_back(treeletNode.right, flatNode.right);
+			m_pairStack.emplace_back(treeletNode.left, flatIndex + 1);
+			//the left child is popped first, so the leaves come out in
+			//order
+		}
+
+		m_nodes.swap(m_flatNodes);
+		m_primitives.swap(m_sortedPrimitives);
+	}
+
+	void BVH::findPairs(std::vector<CollisionPair>& pairs,
+	                    QueryScratch& scratch) const
+	{
+		ZoneScoped;
 
-			leftNode->parent = node;
-			rightNode->parent = node;
+		pairs.clear();
 
-			buildTree(leftNode, start, start + (end - start) / 2);
-			buildTree(rightNode, start + 1 + (end - start) / 2, end);
+		if (m_nodes.empty())
+		{
+			return;
+		}
+
+		//A pair (a, a) stands for "all the pairs within subtree a", while a
+		//pair (a, b) stands for "all the pairs between subtrees a and b"
+		auto& stack = scratch.pairStack;
+		stack.clear();
+		stack.emplace_back(0, 0);
+		PhysiccCounter(nodesVisited);
+		PhysiccCounter(pairsTested);
+
+		while (!stack.empty())
+		{
+			auto [a, b] = stack.back();
+			stack.pop_back();
+			PhysiccCount(nodesVisited, 1);
+
+			const auto& nodeA = m_nodes[a];
+			const auto& nodeB = m_nodes[b];
+
+			if (a == b)
+			{
+				if (!nodeA.isLeaf())
+				{
+					stack.emplace_back(a + 1, nodeA.right);
+					stack.emplace_back(nodeA.right, nodeA.right);
+					stack.emplace_back(a + 1, a + 1);
+				}
+
+				continue;
+			}
+
+			PhysiccCount(pairsTested, 1);
+
+			if (!nodeA.volume.overlapsWith(nodeB.volume))
+			{
+				continue;
+			}
+
+			if (nodeA.isLeaf() && nodeB.isLeaf())
+			{
+				pairs.push_back({std::min(nodeA.body, nodeB.body),
+				                 std::max(nodeA.body, nodeB.body)});
+				continue;
+			}
+
+			//Descend into the bigger of the two subtrees, which shrinks the
+			//volumes being tested the fastest
+			bool descendA = nodeB.isLeaf()
+				|| (!nodeA.isLeaf()
+				    && nodeA.volume.getSurfaceArea()
+				       > nodeB.volume.getSurfaceArea());
+
+			if (descendA)
+			{
+				stack.emplace_back(nodeA.right, b);
+				stack.emplace_back(a + 1, b);
+			} else
+			{
+				stack.emplace_back(a, nodeB.right);
+				stack.emplace_back(a, b + 1);
+			}
+		}
+
+		PhysiccPlot("BVH::findPairs nodes visited", nodesVisited);
+		PhysiccPlot("BVH::findPairs pairs tested", pairsTested);
+	}
+
+	std::optional<RaycastHit> BVH::raycast(const glm::vec3& origin,
+	                                       const glm::vec3& direction,
+	                                       float maxT,
+	                                       QueryScratch& scratch) const
+	{
+		PhysiccZoneFine;
+
+		std::optional<RaycastHit> closest;
+		glm::vec3 inverseDirection = 1.0f / direction;
+		float tEnter;
+
+		if (m_nodes.empty()
+		    || !intersectsSlab(m_nodes[0].volume, origin, inverseDirection,
+		                       maxT, tEnter))
+		{
+			return closest;
 		}
+
+		Ray ray{origin, direction, maxT};
+		//ray.maxT shrinks to the closest hit found so far
+
+		auto& stack = scratch.rayStack;
+		stack.clear();
+		stack.emplace_back(0, tEnter);
+
+		while (!stack.empty())
+		{
+			auto [index, t] = stack.back();
+			stack.pop_back();
+
+			if (t > ray.maxT)
+			{
+				continue;
+			}
+
+			const auto& node = m_nodes[index];
+
+			if (node.isLeaf())
+			{
+				RaycastHit hit;
+
+				if (m_rigidBodyList[node.body].raycast(ray, hit))
+				{
+					hit.body = node.body;
+					ray.maxT = hit.t;
+					closest = hit;
+				}
+
+				continue;
+			}
+
+			float tLeft, tRight;
+			bool hitLeft = intersectsSlab(m_nodes[index + 1].volume, origin,
+			                              inverseDirection, ray.maxT, tLeft);
+			bool hitRight = intersectsSlab(m_nodes[node.right].volume, origin,
+			                               inverseDirection, ray.maxT, tRight);
+
+			//push the farther child first, so that the nearer one is popped
+			//(and can shrink ray.maxT) first
+			if (hitLeft && hitRight)
+			{
+				if (tLeft < tRight)
+				{
+					stack.emplace_back(node.right, tRight);
+					stack.emplace_back(index + 1, tLeft);
+				} else
+				{
+					stack.emplace_back(index + 1, tLeft);
+					stack.emplace_back(node.right, tRight);
+				}
+			} else if (hitLeft)
+			{
+				stack.emplace_back(index + 1, tLeft);
+			} else if (hitRight)
+			{
+				stack.emplace_back(node.right, tRight);
+			}
+		}
+
+		return closest;
+	}
+
+	void BVH::raycast(const std::vector<Ray>& rays,
+	                  std::vector<std::optional<RaycastHit>>& hits,
+	                  QueryScratch& scratch) const
+	{
+		ZoneScoped;
+
+		hits.assign(rays.size(), std::nullopt);
+
+		if (m_nodes.empty())
+		{
+			return;
+		}
+
+		std::array<Ray, packetSize> packet;
+		std::array<glm::vec3, packetSize> inverseDirections;
+		auto& stack = scratch.pairStack;
+		//(node, mask of the rays of the packet that may hit it)
+		PhysiccCounter(nodesVisited);
+
+		for (std::size_t first = 0; first < rays.size(); first += packetSize)
+		{
+			std::size_t count = std::min(packetSize, rays.size() - first);
+
+			for (std::size_t i = 0; i < count; i++)
+			{
+				packet[i] = rays[first + i];
+				inverseDirections[i] = 1.0f / packet[i].direction;
+			}
+
+			stack.clear();
+			stack.emplace_back(0, (1u << count) - 1);
+
+			while (!stack.empty())
+			{
+				auto [index, mask] = stack.back();
+				stack.pop_back();
+				PhysiccCount(nodesVisited, 1);
+
+				const auto& node = m_nodes[index];
+				std::uint32_t active = 0;
+
+				for (std::size_t i = 0; i < count; i++)
+				{
+					float tEnter;
+
+					if ((mask & (1u << i))
+					    && intersectsSlab(node.volume, packet[i].origin,
+					                      inverseDirections[i], packet[i].maxT,
+					                      tEnter))
+					{
+						active |= 1u << i;
+					}
+				}
+
+				if (active == 0)
+				{
+					continue;
+				}
+
+				if (node.isLeaf())
+				{
+					for (std::size_t i = 0; i < count; i++)
+					{
+						RaycastHit hit;
+
+						const auto& body = m_rigidBodyList[node.body];
+
+						if ((active & (1u << i))
+						    && body.raycast(packet[i], hit))
+						{
+							hit.body = node.body;
+							packet[i].maxT = hit.t;
+							hits[first + i] = hit;
+						}
+					}
+
+					continue;
+				}
+
+				//Order the children front to back along the first active
+				//ray; coherent rays mostly agree on that order
+				std::size_t lead = 0;
+
+				while (!(active & (1u << lead)))
+				{
+					lead++;
+				}
+
+				auto distance = [&](std::uint32_t child) {
+					const auto& volume = m_nodes[child].volume;
+					glm::vec3 center = 0.5f * (volume.getLowerBound()
+					                           + volume.getUpperBound());
+
+					return glm::dot(center - packet[lead].origin,
+					                packet[lead].direction);
+				};
+
+				if (distance(index + 1) < distance(node.right))
+				{
+					stack.emplace_back(node.right, active);
+					stack.emplace_back(index + 1, active);
+				} else
+				{
+					stack.emplace_back(index + 1, active);
+					stack.emplace_back(node.right, active);
+				}
+			}
+		}
+
+		PhysiccPlot("BVH::raycast nodes visited", nodesVisited);
 	}
-}
\ No newline at end of file
+}
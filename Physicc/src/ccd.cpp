@@ -0,0 +1,184 @@
+/**
+ * @file ccd.cpp
+ * @brief Time of impact of swept spheres, by conservative advancement.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* ccd header */
+
+#include "tools/Tracy.hpp"
+
+#include "ccd.hpp"
+#include "gjk.hpp"
+#include "profiling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Physicc
+{
+	namespace
+	{
+		constexpr int maxIterations = 32;
+		constexpr float tolerance = 1e-3f;
+		//gap at which the sphere counts as touching
+		constexpr float minRadius = 1e-3f;
+		//so that flat colliders still get swept, as a point, instead of
+		//looking like bodies without CCD
+
+		/**
+		 * @brief Finds the point of a collider closest to a point outside
+		 * of it
+		 *
+		 * @return false if the point is inside the collider
+		 */
+		bool findClosest(const glm::vec3& point, const Collider& target,
+		                 const ConvexShape& shape, SimplexCache& cache,
+		                 glm::vec3& closest, float& distance)
+		{
+			if (target.getType() == Collider::e_sphere)
+			{
+				float radius =
+					static_cast<const SphereCollider&>(target).getRadius();
+				glm::vec3 offset = point - target.getPosition();
+				float length = glm::length(offset);
+
+				if (length <= radius)
+				{
+					return false;
+				}
+
+				closest = target.getPosition() + offset * (radius / length);
+				distance = length - radius;
+				return true;
+			}
+			//exact, and cheaper than GJK against a curved support
+
+			GJKResult result = computeDistance(ConvexShape::fromPoint(point),
+			                                   shape, &cache);
+
+			if (result.intersecting || result.distance <= 0.0f)
+			{
+				return false;
+			}
+
+			closest = result.pointB;
+			distance = result.distance;
+			return true;
+		}
+	}
+
+	float getSweptSphereRadius(const Collider& collider)
+	{
+		float radius = std::numeric_limits<float>::max();
+
+		switch (collider.getType())
+		{
+			case Collider::e_box:
+			{
+				glm::vec3 extents =
+					static_cast<const BoxCollider&>(collider).getHalfExtents();
+				radius = std::min(std::min(extents.x, extents.y), extents.z);
+				break;
+			}
+			case Collider::e_sphere:
+				radius =
+					static_cast<const SphereCollider&>(collider).getRadius();
+				break;
+			case Collider::e_capsule:
+				radius =
+					static_cast<const CapsuleCollider&>(collider).getRadius();
+				break;
+			default:
+			{
+				ConvexShape shape = ConvexShape::fromCollider(collider);
+				glm::mat3 axes = collider.getRotationMatrix();
+
+				for (int i = 0; i < 3; i++)
+				{
+					for (float sign : {1.0f, -1.0f})
+					{
+						glm::vec3 axis = sign * axes[i];
+						glm::vec3 offset =
+							shape.getSupport(axis) - collider.getPosition();
+						radius = std::min(radius, glm::dot(offset, axis));
+					}
+				}
+
+				break;
+			}
+		}
+
+		return std::max(radius, minRadius);
+	}
+
+	bool sweepSphere(const glm::vec3& center, float radius,
+	                 const glm::vec3& displacement, const Collider& target,
+	                 TimeOfImpact& result)
+	{
+		PhysiccZoneFine;
+
+		ConvexShape shape = ConvexShape::fromCollider(target);
+		SimplexCache cache;
+		//consecutive queries differ by a small move of the point, so GJK
+		//restarts from where it stopped
+		float t = 0.0f;
+
+		for (int i = 0; i < maxIterations; i++)
+		{
+			glm::vec3 point = center + t * displacement;
+			glm::vec3 closest;
+			float distance;
+
+			if (!findClosest(point, target, shape, cache, closest, distance))
+			{
+				if (i == 0)
+				{
+					return false;
+				}
+
+				//advancing never overshoots by more than rounding: call it
+				//a contact where the sphere got to
+				result.t = t;
+				result.point = point;
+				result.normal = -glm::normalize(displacement);
+				return true;
+			}
+
+			glm::vec3 normal = (point - closest) / distance;
+			float approach = -glm::dot(normal, displacement);
+			float gap = distance - radius;
+
+			if (gap < 0.0f && i == 0)
+			{
+				return false;
+			}
+
+			if (approach <= 0.0f)
+			{
+				return false;
+			}
+			//moving away from the separating plane, and so from the target
+
+			if (gap <= tolerance)
+			{
+				result.t = t;
+				result.point = closest;
+				result.normal = normal;
+				return true;
+			}
+
+			t += gap / approach;
+
+			if (t > 1.0f)
+			{
+				return false;
+			}
+		}
+
+		return false;
+	}
+}
@@ -16,40 +16,160 @@
 #include "tools/Tracy.hpp"
 
 #include "collider.hpp"
+#include "gjk.hpp"
+
+#include <cmath>
+#include <limits>
+#include <utility>
 
 namespace Physicc
 {
+	namespace
+	{
+		/**
+		 * @brief Casts a ray against a convex shape by conservative
+		 * advancement
+		 *
+		 * GJK gives the closest point of the shape to the current point of
+		 * the ray. The shape lies behind the plane through that point facing
+		 * the ray, so the ray can safely advance to that plane, and the loop
+		 * ends once the distance left is negligible.
+		 */
+		bool raycastConvex(const ConvexShape& shape, const Ray& ray,
+		                   RaycastHit& hit)
+		{
+			constexpr int maxIterations = 32;
+			constexpr float tolerance = 1e-4f;
+
+			float t = 0.0f;
+			glm::vec3 normal = -glm::normalize(ray.direction);
+			//reported as is if the ray starts inside the shape
+
+			for (int i = 0; i < maxIterations; i++)
+			{
+				glm::vec3 point = ray.origin + t * ray.direction;
+				GJKResult closest = computeDistance(
+					ConvexShape::fromPoint(point), shape);
+
+				if (closest.intersecting || closest.distance <= tolerance)
+				{
+					hit.t = t;
+					hit.point = point;
+					hit.normal = normal;
+					return true;
+				}
+
+				normal = (point - closest.pointB) / closest.distance;
+				float approach = -glm::dot(normal, ray.direction);
+
+				if (approach <= 0.0f)
+				{
+					return false;
+				}
+				//the ray points away from the plane, and so from the shape
+
+				t += closest.distance / approach;
+
+				if (t > ray.maxT)
+				{
+					return false;
+				}
+			}
+
+			return false;
+		}
+	}
+
 	/**
 	 * @brief Construct a new Collider:: Collider object
 	 * 
-	 * @param position Position of the object. Default = (0,0,0)
-	 * @param rotation Rotations about the axes. Default = (0,0,0)
-	 * @param scale Length along each of the axes. Default = (1,1,1)
+	 * @param type Shape class the collider is part of
+	 * @param position Position of the object
+	 * @param rotation Rotations about the axes
+	 * @param scale Length along each of the axes
 	 */
-	Collider::Collider(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale)
-		: m_position(position), m_rotate(rotation), m_scale(scale)
+	Collider::Collider(Type type, glm::vec3 position, glm::vec3 rotation,
+	                   glm::vec3 scale)
+		: m_position(position), m_rotate(rotation), m_scale(scale),
+		  m_objectType(type)
 	{
 	}
 
-	/**
-	 * @brief Update Transform for rendering
-	 * 
-	 */
-	void Collider::updateTransform()
+	glm::vec3 Collider::getCentroid() const
+	{
+		switch (m_objectType)
+		{
+			case e_box:
+				return static_cast<const BoxCollider&>(*this).getCentroid();
+			case e_sphere:
+				return static_cast<const SphereCollider&>(*this).getCentroid();
+			case e_convexHull:
+				return static_cast<const ConvexHullCollider&>(*this)
+					.getCentroid();
+			case e_capsule:
+				return static_cast<const CapsuleCollider&>(*this).getCentroid();
+			default:
+				return m_position;
+		}
+	}
+
+	bool Collider::raycast(const Ray& ray, RaycastHit& hit) const
+	{
+		switch (m_objectType)
+		{
+			case e_box:
+				return static_cast<const BoxCollider&>(*this).raycast(ray, hit);
+			case e_sphere:
+				return static_cast<const SphereCollider&>(*this)
+					.raycast(ray, hit);
+			case e_convexHull:
+				return static_cast<const ConvexHullCollider&>(*this)
+					.raycast(ray, hit);
+			case e_capsule:
+				return static_cast<const CapsuleCollider&>(*this)
+					.raycast(ray, hit);
+			default:
+				return false;
+		}
+	}
+
+	BVImpl::AABB Collider::computeLocalBounds() const
 	{
-		ZoneScoped;
+		switch (m_objectType)
+		{
+			case e_box:
+				return static_cast<const BoxCollider&>(*this)
+					.computeLocalBounds();
+			case e_sphere:
+				return static_cast<const SphereCollider&>(*this)
+					.computeLocalBounds();
+			case e_convexHull:
+				return static_cast<const ConvexHullCollider&>(*this)
+					.computeLocalBounds();
+			case e_capsule:
+				return static_cast<const CapsuleCollider&>(*this)
+					.computeLocalBounds();
+			default:
+				return {glm::vec3(0.0f), glm::vec3(0.0f)};
+		}
+	}
+
+	void Collider::computeShape()
+	{
+		PhysiccZoneFine;
 
-		m_transform = glm::translate(glm::mat4(1.0f), m_position);
-		m_transform = glm::scale(m_transform, m_scale);
-		m_transform = glm::rotate(m_transform,
-									glm::radians(m_rotate.x),
-									glm::vec3(1.0, 0.0, 0.0));
-		m_transform = glm::rotate(m_transform,
-									glm::radians(m_rotate.y),
-									glm::vec3(0.0, 1.0, 0.0));
-		m_transform = glm::rotate(m_transform,
-									glm::radians(m_rotate.z),
-									glm::vec3(0.0, 0.0, 1.0));
+		glm::mat4 rotation = glm::rotate(glm::mat4(1.0f),
+		                                 glm::radians(m_rotate.x),
+		                                 glm::vec3(1.0, 0.0, 0.0));
+		rotation = glm::rotate(rotation,
+		                       glm::radians(m_rotate.y),
+		                       glm::vec3(0.0, 1.0, 0.0));
+		rotation = glm::rotate(rotation,
+		                       glm::radians(m_rotate.z),
+		                       glm::vec3(0.0, 0.0, 1.0));
+
+		m_rotation = glm::mat3(rotation);
+		m_localBounds = computeLocalBounds();
 	}
 
 	/**
@@ -63,53 +183,110 @@ namespace Physicc
 	BoxCollider::BoxCollider(glm::vec3 position,
 								glm::vec3 rotation,
 								glm::vec3 scale)
-		: Collider(position, rotation, scale),
-			m_vertices(std::vector<glm::vec4>(8, glm::vec4(0, 0, 0, 1.0f)))
+		: Collider(e_box, position, rotation, scale)
 	{
-		ZoneScoped;
+		computeShape();
+	}
 
-		//Top-face vertices
-		m_vertices[0] = glm::vec4(scale * 0.5f, 0);
-		m_vertices[1] = m_vertices[0] - glm::vec4(scale.x, 0, 0, 0);
-		m_vertices[2] = m_vertices[0] - glm::vec4(0, scale.y, 0, 0);
-		m_vertices[3] = m_vertices[0] - glm::vec4(scale.x, scale.y, 0, 0);
+	/**
+	 * @brief Computes the Axis Aligned Bounding Box of the box, relative to
+	 * its center
+	 *
+	 * Each half extent of the AABB is the sum of the box's half extents
+	 * projected on that world axis, i.e. |R| * halfExtents, with |R| the
+	 * rotation matrix with every entry made positive. No vertex has to be
+	 * transformed.
+	 */
+	BVImpl::AABB BoxCollider::computeLocalBounds() const
+	{
+		PhysiccZoneFine;
+
+		glm::mat3 rotation = getRotationMatrix();
+		glm::mat3 absolute(glm::abs(rotation[0]), glm::abs(rotation[1]),
+		                   glm::abs(rotation[2]));
+		glm::vec3 extents = absolute * getHalfExtents();
 
-		//Bottom-face vertices
-		m_vertices[4] = glm::vec4(scale * -0.5f, 0);
-		m_vertices[5] = m_vertices[0] + glm::vec4(scale.x, 0, 0, 0);
-		m_vertices[6] = m_vertices[0] + glm::vec4(0, scale.y, 0, 0);
-		m_vertices[7] = m_vertices[0] + glm::vec4(scale.x, scale.y, 0, 0);
+		return {-extents, extents};
+	}
+
+	glm::vec3 BoxCollider::getCentroid() const
+	{
+		return m_position;
 	}
 
 	/**
-	 * @brief Computes and returns Axis Aligned Bounding Box of Box shaped object
-	 * 
-	 * Computes location of vertices in global space and finds the 
-	 * extreme points of AABB by comparing each component of every vertex
-	 * 
-	 * @return BoundingVolume::AABB
+	 * @brief Casts a ray against the oriented box
+	 *
+	 * The ray is brought into the box's local frame, where the box is
+	 * axis aligned with half extents of scale / 2, and slab tested there.
 	 */
-	BoundingVolume::AABB BoxCollider::getAABB() const
+	bool BoxCollider::raycast(const Ray& ray, RaycastHit& hit) const
 	{
-		ZoneScoped;
+		glm::mat3 rotation = getRotationMatrix();
+		glm::mat3 inverseRotation = glm::transpose(rotation);
 
-		glm::vec3 lowerBound(0.5f);
-		glm::vec3 upperBound(-0.5f);
+		glm::vec3 origin = inverseRotation * (ray.origin - m_position);
+		glm::vec3 direction = inverseRotation * ray.direction;
+		glm::vec3 halfExtents = getHalfExtents();
 
-		for (int i = 0; i < 8; i++)
+		float tEnter = 0.0f;
+		float tExit = ray.maxT;
+		int enterAxis = -1;
+
+		for (int axis = 0; axis < 3; axis++)
 		{
-			glm::vec3 temp = m_transform * m_vertices[i];
-			lowerBound = glm::min(lowerBound, temp); //Takes component-wise min
-			upperBound = glm::max(upperBound, temp);
+			if (std::abs(direction[axis])
+			    < std::numeric_limits<float>::epsilon())
+			{
+				//parallel to this slab, so it must already be inside it
+				if (std::abs(origin[axis]) > halfExtents[axis])
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			float inverse = 1.0f / direction[axis];
+			float t1 = (-halfExtents[axis] - origin[axis]) * inverse;
+			float t2 = (halfExtents[axis] - origin[axis]) * inverse;
+
+			if (t1 > t2)
+			{
+				std::swap(t1, t2);
+			}
+
+			if (t1 > tEnter)
+			{
+				tEnter = t1;
+				enterAxis = axis;
+			}
+
+			tExit = std::min(tExit, t2);
+
+			if (tEnter > tExit)
+			{
+				return false;
+			}
 		}
 
-		return {lowerBound, upperBound};
-		//returning initializer list instead of an actual object
-	}
+		glm::vec3 normal(0.0f);
 
-	glm::vec3 BoxCollider::getCentroid() const
-	{
-		return m_position;
+		if (enterAxis == -1)
+		{
+			normal = -glm::normalize(ray.direction);
+			//the ray starts inside the box
+		} else
+		{
+			normal[enterAxis] = direction[enterAxis] > 0.0f ? -1.0f : 1.0f;
+			normal = rotation * normal;
+		}
+
+		hit.t = tEnter;
+		hit.point = ray.origin + tEnter * ray.direction;
+		hit.normal = normal;
+
+		return true;
 	}
 
 	/**
@@ -125,31 +302,199 @@ namespace Physicc
 									glm::vec3 position,
 									glm::vec3 rotation,
 									glm::vec3 scale)
-		: Collider(position, rotation, scale), m_radius(radius)
+		: Collider(e_sphere, position, rotation, scale), m_radius(radius)
+	{
+		computeShape();
+	}
+
+	/**
+	 * @brief Computes the Axis Aligned Bounding Box of the sphere, relative
+	 * to its center
+	 */
+	BVImpl::AABB SphereCollider::computeLocalBounds() const
+	{
+		PhysiccZoneFine;
+
+		return {glm::vec3(-m_radius), glm::vec3(m_radius)};
+	}
+
+	glm::vec3 SphereCollider::getCentroid() const
 	{
-		ZoneScoped;
+		return m_position;
+	}
+
+	/**
+	 * @brief Casts a ray against the sphere
+	 *
+	 * Solves |origin + t * direction - center|^2 = radius^2 for the smallest
+	 * non-negative t.
+	 */
+	bool SphereCollider::raycast(const Ray& ray, RaycastHit& hit) const
+	{
+		glm::vec3 offset = ray.origin - m_position;
+
+		float a = glm::dot(ray.direction, ray.direction);
+		float b = glm::dot(offset, ray.direction);
+		float c = glm::dot(offset, offset) - m_radius * m_radius;
+
+		if (c <= 0.0f)
+		{
+			//the ray starts inside the sphere
+			hit.t = 0.0f;
+			hit.point = ray.origin;
+			hit.normal = -glm::normalize(ray.direction);
+			return true;
+		}
+
+		float discriminant = b * b - a * c;
+
+		if (b > 0.0f || discriminant < 0.0f)
+		{
+			return false;
+		}
+		//b > 0 means the ray points away from the sphere
+
+		float t = (-b - std::sqrt(discriminant)) / a;
+
+		if (t > ray.maxT)
+		{
+			return false;
+		}
 
-		m_objectType = e_sphere;
+		hit.t = t;
+		hit.point = ray.origin + t * ray.direction;
+		hit.normal = (hit.point - m_position) / m_radius;
+
+		return true;
+	}
+
+	ConvexHull::ConvexHull(std::vector<glm::vec3> vertices)
+		: m_vertices(std::move(vertices)), m_centroid(0.0f)
+	{
+		for (const auto& vertex : m_vertices)
+		{
+			m_centroid += vertex;
+		}
+
+		if (!m_vertices.empty())
+		{
+			m_centroid /= static_cast<float>(m_vertices.size());
+		}
 	}
 
 	/**
-	 * @brief Computes and returns Axis Aligned Bounding Box of Sphere shaped object
-	 * 
-	 * @return BoundingVolume::AABB
+	 * @brief Creates a ConvexHullCollider object
+	 *
+	 * @param hull Shape of the collider, which must outlive it
+	 * @param position Position of object in global space
+	 * @param rotation Rotation about each of the axis in local space
+	 * @param scale Scale of the object along each axis
 	 */
-	BoundingVolume::AABB SphereCollider::getAABB() const
+	ConvexHullCollider::ConvexHullCollider(const ConvexHull& hull,
+	                                       glm::vec3 position,
+	                                       glm::vec3 rotation,
+	                                       glm::vec3 scale)
+		: Collider(e_convexHull, position, rotation, scale), m_hull(&hull)
 	{
-		ZoneScoped;
+		computeShape();
+	}
 
-		glm::vec3 lowerBound = m_position - m_radius;;
-		glm::vec3 upperBound = m_position + m_radius;
+	/**
+	 * @brief Computes the AABB of the hull, from its support points along
+	 * the world axes, relative to its position
+	 */
+	BVImpl::AABB ConvexHullCollider::computeLocalBounds() const
+	{
+		PhysiccZoneFine;
 
-		return {lowerBound, upperBound};
+		ConvexShape shape = ConvexShape::fromCollider(*this);
+		glm::vec3 lowerBound;
+		glm::vec3 upperBound;
+
+		for (int i = 0; i < 3; i++)
+		{
+			glm::vec3 axis(0.0f);
+			axis[i] = 1.0f;
+
+			lowerBound[i] = shape.getSupport(-axis)[i];
+			upperBound[i] = shape.getSupport(axis)[i];
+		}
+
+		return {lowerBound - m_position, upperBound - m_position};
 	}
 
-	glm::vec3 SphereCollider::getCentroid() const
+	glm::vec3 ConvexHullCollider::getCentroid() const
+	{
+		return m_position
+			+ getRotationMatrix() * (m_scale * m_hull->getCentroid());
+	}
+
+	bool ConvexHullCollider::raycast(const Ray& ray, RaycastHit& hit) const
+	{
+		PhysiccZoneFine;
+
+		return raycastConvex(ConvexShape::fromCollider(*this), ray, hit);
+	}
+
+	/**
+	 * @brief Creates a CapsuleCollider object
+	 *
+	 * @param radius Radius of the capsule
+	 * @param halfHeight Half the length of the capsule's segment
+	 * @param position Position of object in global space
+	 * @param rotation Rotation about each of the axis in local space
+	 * @param scale Scale of the object along each axis
+	 */
+	CapsuleCollider::CapsuleCollider(float radius,
+	                                 float halfHeight,
+	                                 glm::vec3 position,
+	                                 glm::vec3 rotation,
+	                                 glm::vec3 scale)
+		: Collider(e_capsule, position, rotation, scale),
+		  m_radius(radius),
+		  m_halfHeight(halfHeight)
+	{
+		computeShape();
+	}
+
+	/**
+	 * @brief Computes the AABB of the capsule, relative to its center: the
+	 * AABB of its segment, grown by the radius
+	 */
+	BVImpl::AABB CapsuleCollider::computeLocalBounds() const
+	{
+		PhysiccZoneFine;
+
+		glm::vec3 extents = glm::abs(getRotationMatrix()[1]) * m_halfHeight +
+		                    m_radius;
+
+		return {-extents, extents};
+	}
+
+	glm::vec3 CapsuleCollider::getCentroid() const
 	{
 		return m_position;
 	}
-}
 
+	bool CapsuleCollider::raycast(const Ray& ray, RaycastHit& hit) const
+	{
+		PhysiccZoneFine;
+
+		return raycastConvex(ConvexShape::fromCollider(*this), ray, hit);
+	}
+
+	ColliderShape ColliderShape::fromCollider(const Collider& collider)
+	{
+		switch (collider.getType())
+		{
+			case Collider::e_box:
+				return static_cast<const BoxCollider&>(collider);
+			case Collider::e_sphere:
+				return static_cast<const SphereCollider&>(collider);
+			case Collider::e_capsule:
+				return static_cast<const CapsuleCollider&>(collider);
+			default:
+				return static_cast<const ConvexHullCollider&>(collider);
+		}
+	}
+}
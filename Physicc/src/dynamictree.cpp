@@ -0,0 +1,418 @@
+/**
+ * @file dynamictree.cpp
+ * @brief An incrementally updated AABB tree for moving bodies.
+ *
+ * Leaves store fattened AABBs, so that bodies moving by less than the margin
+ * don't need to be reinserted, and the tree is rebalanced with rotations on
+ * every insertion and removal.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* dynamictree header */
+
+#include "tools/Tracy.hpp"
+
+#include "dynamictree.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace Physicc
+{
+	namespace
+	{
+		constexpr std::uint32_t nullIndex = DynamicTreeNode::nullIndex;
+	}
+
+	DynamicTree::DynamicTree(float margin)
+		: m_root(nullIndex), m_freeList(nullIndex), m_margin(margin)
+	{
+	}
+
+	std::uint32_t DynamicTree::allocateNode()
+	{
+		if (m_freeList == nullIndex)
+		{
+			m_nodes.emplace_back();
+			return static_cast<std::uint32_t>(m_nodes.size() - 1);
+		}
+
+		std::uint32_t node = m_freeList;
+		m_freeList = m_nodes[node].parent;
+		m_nodes[node] = DynamicTreeNode();
+
+		return node;
+	}
+
+	void DynamicTree::freeNode(std::uint32_t node)
+	{
+		m_nodes[node].parent = m_freeList;
+		m_nodes[node].height = -1;
+		m_freeList = node;
+	}
+
+	std::uint32_t DynamicTree::insert(const BoundingVolume::AABB& volume,
+	                                  std::size_t body)
+	{
+		PhysiccZoneFine;
+
+		std::uint32_t proxy = allocateNode();
+
+		m_nodes[proxy].volume = volume.fattened(m_margin);
+		m_nodes[proxy].body = body;
+		m_nodes[proxy].height = 0;
+
+		insertLeaf(proxy);
+
+		return proxy;
+	}
+
+	void DynamicTree::remove(std::uint32_t proxy)
+	{
+		PhysiccZoneFine;
+
+		removeLeaf(proxy);
+		freeNode(proxy);
+	}
+
+	bool DynamicTree::move(std::uint32_t proxy,
+	                       const BoundingVolume::AABB& volume)
+	{
+		if (m_nodes[proxy].volume.contains(volume))
+		{
+			return false;
+		}
+
+		removeLeaf(proxy);
+		m_nodes[proxy].volume = volume.fattened(m_margin);
+		insertLeaf(proxy);
+
+		return true;
+	}
+
+	/**
+	 * @brief Finds the best sibling for leaf and links it in the tree
+	 *
+	 * Descends from the root towards the child whose bounding volume grows
+	 * the least (in surface area) by enclosing the leaf, and stops as soon
+	 * as creating a new parent at the current node is cheaper.
+	 */
+	void DynamicTree::insertLeaf(std::uint32_t leaf)
+	{
+		if (m_root == nullIndex)
+		{
+			m_root = leaf;
+			m_nodes[leaf].parent = nullIndex;
+			return;
+		}
+
+		const auto leafVolume = m_nodes[leaf].volume;
+		std::uint32_t sibling = m_root;
+
+		while (!m_nodes[sibling].isLeaf())
+		{
+			const auto& node = m_nodes[sibling];
+
+			float area = node.volume.getSurfaceArea();
+			float combinedArea = BoundingVolume::enclosingBV(node.volume,
+			                                                 leafVolume)
+				.getSurfaceArea();
+
+			//cost of creating a new parent for this node and the leaf
+			float cost = 2.0f * combinedArea;
+
+			//minimum cost of pushing the leaf further down the tree
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](std::uint32_t child) {
+				float enlarged = BoundingVolume::enclosingBV(
+					m_nodes[child].volume, leafVolume).getSurfaceArea();
+
+				if (m_nodes[child].isLeaf())
+				{
+					return enlarged + inheritanceCost;
+				}
+
+				return enlarged - m_nodes[child].volume.getSurfaceArea()
+					+ inheritanceCost;
+			};
+
+			float leftCost = descendCost(node.left);
+			float rightCost = descendCost(node.right);
+
+			if (cost < leftCost && cost < rightCost)
+			{
+				break;
+			}
+
+			sibling = leftCost < rightCost ? node.left : node.right;
+		}
+
+		std::uint32_t oldParent = m_nodes[sibling].parent;
+		std::uint32_t newParent = allocateNode();
+
+		m_nodes[newParent].parent = oldParent;
+		m_nodes[newParent].volume = BoundingVolume::enclosingBV(
+			leafVolume, m_nodes[sibling].volume);
+		m_nodes[newParent].height = m_nodes[sibling].height + 1;
+		m_nodes[newParent].left = sibling;
+		m_nodes[newParent].right = leaf;
+
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		if (oldParent == nullIndex)
+		{
+			m_root = newParent;
+		} else if (m_nodes[oldParent].left == sibling)
+		{
+			m_nodes[oldParent].left = newParent;
+		} else
+		{
+			m_nodes[oldParent].right = newParent;
+		}
+
+		refitAncestors(m_nodes[leaf].parent);
+	}
+
+	void DynamicTree::removeLeaf(std::uint32_t leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = nullIndex;
+			return;
+		}
+
+		std::uint32_t parent = m_nodes[leaf].parent;
+		std::uint32_t grandParent = m_nodes[parent].parent;
+		std::uint32_t sibling = m_nodes[parent].left == leaf
+			? m_nodes[parent].right
+			: m_nodes[parent].left;
+
+		//The parent is removed along with the leaf, and the sibling takes
+		//its place
+		if (grandParent == nullIndex)
+		{
+			m_root = sibling;
+			m_nodes[sibling].parent = nullIndex;
+			freeNode(parent);
+			return;
+		}
+
+		if (m_nodes[grandParent].left == parent)
+		{
+			m_nodes[grandParent].left = sibling;
+		} else
+		{
+			m_nodes[grandParent].right = sibling;
+		}
+
+		m_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		refitAncestors(grandParent);
+	}
+
+	/**
+	 * @brief Walks up from node, rebalancing and refitting every ancestor
+	 */
+	void DynamicTree::refitAncestors(std::uint32_t node)
+	{
+		while (node != nullIndex)
+		{
+			node = balance(node);
+
+			auto& current = m_nodes[node];
+			const auto& left = m_nodes[current.left];
+			const auto& right = m_nodes[current.right];
+
+			current.height = 1 + std::max(left.height, right.height);
+			current.volume = BoundingVolume::enclosingBV(left.volume,
+			                                             right.volume);
+
+			node = current.parent;
+		}
+	}
+
+	/**
+	 * @brief Performs a left or right rotation if node a is imbalanced
+	 *
+	 * If one child of a is more than one level taller than the other, the
+	 * taller child is rotated up to take a's place. The shorter grandchild
+	 * moves under a, and the taller one stays under the child that was
+	 * rotated up.
+	 *
+	 * @return The index of the node that is now at a's place in the tree
+	 */
+	std::uint32_t DynamicTree::balance(std::uint32_t a)
+	{
+		auto& nodeA = m_nodes[a];
+
+		if (nodeA.isLeaf() || nodeA.height < 2)
+		{
+			return a;
+		}
+
+		std::uint32_t b = nodeA.left;
+		std::uint32_t c = nodeA.right;
+		std::int32_t balanceFactor = m_nodes[c].height - m_nodes[b].height;
+
+		if (std::abs(balanceFactor) <= 1)
+		{
+			return a;
+		}
+
+		//rotate the taller child (up) into a's place
+		std::uint32_t up = balanceFactor > 0 ? c : b;
+		std::uint32_t other = balanceFactor > 0 ? b : c;
+
+		auto& nodeUp = m_nodes[up];
+		std::uint32_t f = nodeUp.left;
+		std::uint32_t g = nodeUp.right;
+
+		nodeUp.left = a;
+		nodeUp.parent = nodeA.parent;
+		nodeA.parent = up;
+
+		if (nodeUp.parent == nullIndex)
+		{
+			m_root = up;
+		} else if (m_nodes[nodeUp.parent].left == a)
+		{
+			m_nodes[nodeUp.parent].left = up;
+		} else
+		{
+			m_nodes[nodeUp.parent].right = up;
+		}
+
+		//the taller grandchild stays with `up`, the shorter one goes to a
+		std::uint32_t taller = m_nodes[f].height > m_nodes[g].height ? f : g;
+		std::uint32_t shorter = taller == f ? g : f;
+
+		nodeUp.right = taller;
+		nodeA.left = other;
+		nodeA.right = shorter;
+		m_nodes[shorter].parent = a;
+
+		nodeA.volume = BoundingVolume::enclosingBV(m_nodes[other].volume,
+		                                           m_nodes[shorter].volume);
+		nodeA.height = 1 + std::max(m_nodes[other].height,
+		                            m_nodes[shorter].height);
+
+		nodeUp.volume = BoundingVolume::enclosingBV(nodeA.volume,
+		                                            m_nodes[taller].volume);
+		nodeUp.height = 1 + std::max(nodeA.height, m_nodes[taller].height);
+
+		return up;
+	}
+
+	DynamicTreeBroadphase::DynamicTreeBroadphase(float margin)
+		: m_tree(margin)
+	{
+	}
+
+	/**
+	 * @brief Puts a body in the move buffer, once
+	 */
+	void DynamicTreeBroadphase::addMoved(std::size_t body)
+	{
+		if (body >= m_moved.size())
+		{
+			m_moved.resize(body + 1, false);
+		}
+
+		if (!m_moved[body])
+		{
+			m_moved[body] = true;
+			m_moveBuffer.push_back(body);
+		}
+	}
+
+	void DynamicTreeBroadphase::insert(std::size_t body,
+	                                   const BoundingVolume::AABB& volume)
+	{
+		if (body >= m_proxies.size())
+		{
+			m_proxies.resize(body + 1, nullIndex);
+		}
+
+		m_proxies[body] = m_tree.insert(volume, body);
+		addMoved(body);
+	}
+
+	void DynamicTreeBroadphase::remove(std::size_t body)
+	{
+		m_tree.remove(m_proxies[body]);
+		m_proxies[body] = nullIndex;
+		addMoved(body);
+		//so that its pairs get dropped
+	}
+
+	void DynamicTreeBroadphase::update(std::size_t body,
+	                                   const BoundingVolume::AABB& volume)
+	{
+		if (m_tree.move(m_proxies[body], volume))
+		{
+			addMoved(body);
+		}
+	}
+
+	/**
+	 * @brief Drops the pairs of the moved bodies, and queries the tree with
+	 * the fat AABB of each of them to find their pairs again
+	 *
+	 * The kept pairs stay in their order, and the new ones are appended in
+	 * the order of the move buffer, so the order of the pairs only depends
+	 * on the order of the calls. A pair of two moved bodies is only added
+	 * from its lower-indexed body, so each one is found exactly once.
+	 */
+	void DynamicTreeBroadphase::findPairs(std::vector<CollisionPair>& pairs)
+	{
+		ZoneScoped;
+
+		PhysiccCounter(nodesVisited);
+		PhysiccPlot("DynamicTree moved proxies",
+		            static_cast<std::int64_t>(m_moveBuffer.size()));
+
+		if (!m_moveBuffer.empty())
+		{
+			m_pairs.erase(std::remove_if(m_pairs.begin(), m_pairs.end(),
+				[this](const CollisionPair& pair) {
+					return m_moved[pair.first] || m_moved[pair.second];
+				}), m_pairs.end());
+
+			for (std::size_t body : m_moveBuffer)
+			{
+				if (m_proxies[body] == nullIndex)
+				{
+					continue;
+				}
+
+				const auto& volume = m_tree.getFatAABB(m_proxies[body]);
+				std::size_t visited = m_tree.query(volume,
+					[this, body](std::size_t other) {
+						if (other != body && (!m_moved[other] || body < other))
+						{
+							m_pairs.push_back({std::min(body, other),
+							                   std::max(body, other)});
+						}
+
+						return true;
+					});
+				PhysiccCount(nodesVisited, visited);
+			}
+
+			for (std::size_t body : m_moveBuffer)
+			{
+				m_moved[body] = false;
+			}
+
+			m_moveBuffer.clear();
+		}
+
+		PhysiccPlot("DynamicTree nodes visited", nodesVisited);
+		pairs.assign(m_pairs.begin(), m_pairs.end());
+	}
+}
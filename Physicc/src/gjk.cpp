@@ -0,0 +1,830 @@
+/**
+ * @file gjk.cpp
+ * @brief Distance and penetration queries between convex shapes.
+ *
+ * GJK finds the point of the Minkowski difference A - B closest to the
+ * origin, using Ericson's closest point routines on the simplex. When the
+ * origin is inside, EPA expands the last simplex into a polytope until the
+ * face closest to the origin lies on the boundary of A - B.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* gjk header */
+
+#include "tools/Tracy.hpp"
+
+#include "gjk.hpp"
+#include "profiling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+
+namespace Physicc
+{
+	namespace
+	{
+		constexpr std::uint32_t maxGJKIterations = 32;
+		constexpr std::uint32_t maxEPAIterations = 128;
+		constexpr std::size_t maxEPAVertices = 4 + maxEPAIterations;
+		constexpr std::size_t maxEPAFaces = 512;
+		constexpr std::size_t maxEPAEdges = 512;
+
+		constexpr float gjkTolerance = 1e-4f;
+		//relative progress under which GJK stops
+		constexpr float touchingTolerance = 1e-10f;
+		//squared distance, relative to the squared size of the simplex,
+		//under which the shapes are considered touching
+		constexpr float epaTolerance = 1e-4f;
+		constexpr float degenerate = 1e-12f;
+
+		inline SupportPoint support(const ConvexShape& a, const ConvexShape& b,
+		                            const glm::vec3& direction)
+		{
+			glm::vec3 pointA = a.getSupport(direction);
+			glm::vec3 pointB = b.getSupport(-direction);
+
+			return {pointA - pointB, pointA, pointB};
+		}
+
+		struct Simplex
+		{
+			SupportPoint vertices[4];
+			float weights[4];
+			std::uint32_t count = 0;
+
+			inline void keep(std::initializer_list<std::uint32_t> indices,
+			                 std::initializer_list<float> newWeights)
+			{
+				SupportPoint kept[4];
+				std::uint32_t n = 0;
+
+				for (std::uint32_t i : indices)
+				{
+					kept[n++] = vertices[i];
+				}
+
+				n = 0;
+
+				for (float w : newWeights)
+				{
+					vertices[n] = kept[n];
+					weights[n] = w;
+					n++;
+				}
+
+				count = n;
+			}
+		};
+
+		/**
+		 * @brief Reduces a segment to its feature closest to the origin
+		 */
+		glm::vec3 closestOnSegment(Simplex& simplex)
+		{
+			const glm::vec3& a = simplex.vertices[0].point;
+			const glm::vec3& b = simplex.vertices[1].point;
+			glm::vec3 ab = b - a;
+			float length2 = glm::dot(ab, ab);
+			float t = length2 > degenerate ? -glm::dot(a, ab) / length2 : 0.0f;
+
+			if (t <= 0.0f)
+			{
+				simplex.keep({0}, {1.0f});
+				return simplex.vertices[0].point;
+			}
+
+			if (t >= 1.0f)
+			{
+				simplex.keep({1}, {1.0f});
+				return simplex.vertices[0].point;
+			}
+
+			simplex.weights[0] = 1.0f - t;
+			simplex.weights[1] = t;
+
+			return a + t * ab;
+		}
+
+		/**
+		 * @brief Reduces a triangle to its feature closest to the origin
+		 *
+		 * Voronoi region tests from Ericson, Real-Time Collision Detection,
+		 * 5.1.5, with the query point at the origin.
+		 */
+		glm::vec3 closestOnTriangle(Simplex& simplex)
+		{
+			glm::vec3 a = simplex.vertices[0].point;
+			glm::vec3 b = simplex.vertices[1].point;
+			glm::vec3 c = simplex.vertices[2].point;
+			glm::vec3 ab = b - a;
+			glm::vec3 ac = c - a;
+
+			float d1 = -glm::dot(ab, a);
+			float d2 = -glm::dot(ac, a);
+
+			if (d1 <= 0.0f && d2 <= 0.0f)
+			{
+				simplex.keep({0}, {1.0f});
+				return a;
+			}
+
+			float d3 = -glm::dot(ab, b);
+			float d4 = -glm::dot(ac, b);
+
+			if (d3 >= 0.0f && d4 <= d3)
+			{
+				simplex.keep({1}, {1.0f});
+				return b;
+			}
+
+			float vc = d1 * d4 - d3 * d2;
+
+			if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			{
+				float v = d1 / (d1 - d3);
+				simplex.keep({0, 1}, {1.0f - v, v});
+				return a + v * ab;
+			}
+
+			float d5 = -glm::dot(ab, c);
+			float d6 = -glm::dot(ac, c);
+
+			if (d6 >= 0.0f && d5 <= d6)
+			{
+				simplex.keep({2}, {1.0f});
+				return c;
+			}
+
+			float vb = d5 * d2 - d1 * d6;
+
+			if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			{
+				float w = d2 / (d2 - d6);
+				simplex.keep({0, 2}, {1.0f - w, w});
+				return a + w * ac;
+			}
+
+			float va = d3 * d6 - d5 * d4;
+
+			if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+			{
+				float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+				simplex.keep({1, 2}, {1.0f - w, w});
+				return b + w * (c - b);
+			}
+
+			float sum = va + vb + vc;
+
+			if (sum <= degenerate)
+			{
+				//flat triangle: its closest edge will do
+				simplex.keep({0, 1}, {0.0f, 0.0f});
+				return closestOnSegment(simplex);
+			}
+
+			float v = vb / sum;
+			float w = vc / sum;
+			simplex.weights[0] = 1.0f - v - w;
+			simplex.weights[1] = v;
+			simplex.weights[2] = w;
+
+			return a + v * ab + w * ac;
+		}
+
+		/**
+		 * @brief Reduces a tetrahedron to its feature closest to the origin,
+		 * or leaves it whole if it contains the origin
+		 */
+		glm::vec3 closestOnTetrahedron(Simplex& simplex)
+		{
+			static constexpr std::uint32_t faces[4][4] = {
+				{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}
+			};
+			//three vertices of a face, then the vertex opposite to it
+
+			glm::vec3 best(0.0f);
+			float bestDistance = std::numeric_limits<float>::infinity();
+			Simplex bestSimplex;
+			bool inside = true;
+
+			for (const auto& face : faces)
+			{
+				const glm::vec3& a = simplex.vertices[face[0]].point;
+				const glm::vec3& b = simplex.vertices[face[1]].point;
+				const glm::vec3& c = simplex.vertices[face[2]].point;
+				const glm::vec3& d = simplex.vertices[face[3]].point;
+				glm::vec3 normal = glm::cross(b - a, c - a);
+
+				float signOrigin = -glm::dot(normal, a);
+				float signOpposite = glm::dot(normal, d - a);
+
+				if (signOrigin * signOpposite >= 0.0f && signOpposite != 0.0f)
+				{
+					continue;
+				}
+				//the origin is on the same side as the opposite vertex, or
+				//on the face itself
+
+				inside = false;
+
+				Simplex triangle;
+				triangle.vertices[0] = simplex.vertices[face[0]];
+				triangle.vertices[1] = simplex.vertices[face[1]];
+				triangle.vertices[2] = simplex.vertices[face[2]];
+				triangle.count = 3;
+
+				glm::vec3 point = closestOnTriangle(triangle);
+				float distance = glm::dot(point, point);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = point;
+					bestSimplex = triangle;
+				}
+			}
+
+			if (inside)
+			{
+				return glm::vec3(0.0f);
+			}
+
+			simplex = bestSimplex;
+
+			return best;
+		}
+
+		glm::vec3 closestPoint(Simplex& simplex)
+		{
+			switch (simplex.count)
+			{
+				case 1:
+					simplex.weights[0] = 1.0f;
+					return simplex.vertices[0].point;
+				case 2:
+					return closestOnSegment(simplex);
+				case 3:
+					return closestOnTriangle(simplex);
+				default:
+					return closestOnTetrahedron(simplex);
+			}
+		}
+
+		/**
+		 * @brief Barycentric coordinates of p in triangle abc (Ericson 3.4)
+		 */
+		glm::vec3 barycentric(const glm::vec3& a, const glm::vec3& b,
+		                      const glm::vec3& c, const glm::vec3& p)
+		{
+			glm::vec3 v0 = b - a;
+			glm::vec3 v1 = c - a;
+			glm::vec3 v2 = p - a;
+			float d00 = glm::dot(v0, v0);
+			float d01 = glm::dot(v0, v1);
+			float d11 = glm::dot(v1, v1);
+			float d20 = glm::dot(v2, v0);
+			float d21 = glm::dot(v2, v1);
+			float denominator = d00 * d11 - d01 * d01;
+
+			if (std::abs(denominator) <= degenerate)
+			{
+				return {1.0f, 0.0f, 0.0f};
+			}
+
+			float v = (d11 * d20 - d01 * d21) / denominator;
+			float w = (d00 * d21 - d01 * d20) / denominator;
+
+			return {1.0f - v - w, v, w};
+		}
+
+		struct Face
+		{
+			std::uint32_t vertices[3];
+			glm::vec3 normal;
+			float distance;
+		};
+
+		struct Edge
+		{
+			std::uint32_t from;
+			std::uint32_t to;
+		};
+
+		/**
+		 * @brief Orients a face outwards, given a point inside the polytope
+		 */
+		Face makeFace(const SupportPoint* vertices, std::uint32_t a,
+		              std::uint32_t b, std::uint32_t c, const glm::vec3& inner)
+		{
+			Face face{{a, b, c}, glm::vec3(0.0f),
+			          std::numeric_limits<float>::infinity()};
+
+			const glm::vec3& origin = vertices[a].point;
+			glm::vec3 normal = glm::cross(vertices[b].point - origin,
+			                              vertices[c].point - origin);
+
+			if (glm::dot(normal, vertices[a].point - inner) < 0.0f)
+			{
+				std::swap(face.vertices[1], face.vertices[2]);
+				normal = -normal;
+			}
+
+			float length = glm::length(normal);
+
+			if (length > degenerate)
+			{
+				face.normal = normal / length;
+				face.distance = glm::dot(face.normal, vertices[a].point);
+			}
+			//degenerate faces keep an infinite distance, so they are never
+			//picked as the closest face
+
+			return face;
+		}
+	}
+
+	ConvexShape ConvexShape::fromCollider(const Collider& collider)
+	{
+		ConvexShape shape;
+		shape.m_center = collider.getPosition();
+		shape.m_axes = collider.getRotationMatrix();
+
+		switch (collider.getType())
+		{
+			case Collider::e_box:
+				shape.m_kind = e_box;
+				shape.m_extents =
+					static_cast<const BoxCollider&>(collider).getHalfExtents();
+				break;
+			case Collider::e_sphere:
+				shape.m_kind = e_sphere;
+				shape.m_axes = glm::mat3(1.0f);
+				shape.m_extents.x =
+					static_cast<const SphereCollider&>(collider).getRadius();
+				break;
+			case Collider::e_capsule:
+			{
+				const auto& capsule =
+					static_cast<const CapsuleCollider&>(collider);
+				shape.m_kind = e_capsule;
+				shape.m_extents.x = capsule.getRadius();
+				shape.m_extents.y = capsule.getHalfHeight();
+				break;
+			}
+			default:
+			{
+				const auto& hull =
+					static_cast<const ConvexHullCollider&>(collider);
+				shape.m_kind = e_hull;
+				shape.m_extents = collider.getScale();
+				shape.m_vertices = &hull.getVertices();
+				break;
+			}
+		}
+
+		return shape;
+	}
+
+	ConvexShape ConvexShape::fromPoint(const glm::vec3& point)
+	{
+		ConvexShape shape;
+		shape.m_center = point;
+
+		return shape;
+	}
+
+	glm::vec3 ConvexShape::getSupport(const glm::vec3& direction) const
+	{
+		switch (m_kind)
+		{
+			case e_box:
+			{
+				glm::vec3 local = glm::transpose(m_axes) * direction;
+				glm::vec3 corner(local.x < 0.0f ? -m_extents.x : m_extents.x,
+				                 local.y < 0.0f ? -m_extents.y : m_extents.y,
+				                 local.z < 0.0f ? -m_extents.z : m_extents.z);
+
+				return m_center + m_axes * corner;
+			}
+			case e_sphere:
+			{
+				float length = glm::length(direction);
+
+				if (length <= degenerate)
+				{
+					return m_center + glm::vec3(m_extents.x, 0.0f, 0.0f);
+				}
+
+				return m_center + direction * (m_extents.x / length);
+			}
+			case e_capsule:
+			{
+				glm::vec3 axis = m_axes[1];
+				float halfLength = glm::dot(axis, direction) < 0.0f
+					? -m_extents.y
+					: m_extents.y;
+				glm::vec3 end = m_center + axis * halfLength;
+				//the furthest end of the segment, then the sphere around it
+				float length = glm::length(direction);
+
+				if (length <= degenerate)
+				{
+					return end + glm::vec3(m_extents.x, 0.0f, 0.0f);
+				}
+
+				return end + direction * (m_extents.x / length);
+			}
+			case e_hull:
+			{
+				if (m_vertices->empty())
+				{
+					return m_center;
+				}
+
+				glm::vec3 local = m_extents
+					* (glm::transpose(m_axes) * direction);
+				//the hull is scaled after its points are picked, so the
+				//direction is scaled instead (the inverse transpose of the
+				//scale, up to a positive factor)
+				const glm::vec3* furthest = &m_vertices->front();
+				float furthestDistance = glm::dot(*furthest, local);
+
+				for (const auto& vertex : *m_vertices)
+				{
+					float distance = glm::dot(vertex, local);
+
+					if (distance > furthestDistance)
+					{
+						furthestDistance = distance;
+						furthest = &vertex;
+					}
+				}
+
+				return m_center + m_axes * (m_extents * *furthest);
+			}
+			default:
+				return m_center;
+		}
+	}
+
+	GJKResult computeDistance(const ConvexShape& a, const ConvexShape& b,
+	                          SimplexCache* cache)
+	{
+		PhysiccZoneFine;
+
+		Simplex simplex;
+
+		if (cache != nullptr && cache->count > 0)
+		{
+			for (std::uint32_t i = 0; i < cache->count; i++)
+			{
+				glm::vec3 pointA = a.toWorld(cache->localA[i]);
+				glm::vec3 pointB = b.toWorld(cache->localB[i]);
+				simplex.vertices[i] = {pointA - pointB, pointA, pointB};
+			}
+
+			simplex.count = cache->count;
+		}
+		else
+		{
+			glm::vec3 direction = b.getCenter() - a.getCenter();
+
+			if (glm::dot(direction, direction) <= degenerate)
+			{
+				direction = glm::vec3(1.0f, 0.0f, 0.0f);
+			}
+
+			simplex.vertices[0] = support(a, b, direction);
+			simplex.count = 1;
+		}
+
+		GJKResult result{};
+		glm::vec3 closest(0.0f);
+		Simplex previous;
+		glm::vec3 previousClosest(0.0f);
+		float previousDistance2 = std::numeric_limits<float>::infinity();
+
+		for (result.iterations = 1; ; result.iterations++)
+		{
+			closest = closestPoint(simplex);
+
+			if (simplex.count == 4)
+			{
+				result.intersecting = true;
+				break;
+			}
+
+			float distance2 = glm::dot(closest, closest);
+			float size2 = 0.0f;
+
+			for (std::uint32_t i = 0; i < simplex.count; i++)
+			{
+				const glm::vec3& point = simplex.vertices[i].point;
+				size2 = std::max(size2, glm::dot(point, point));
+			}
+
+			if (distance2 <= touchingTolerance * size2
+			    || distance2 <= degenerate)
+			{
+				result.intersecting = true;
+				break;
+			}
+			//touching counts as intersecting, with a depth of 0
+
+			if (distance2 >= previousDistance2)
+			{
+				simplex = previous;
+				closest = previousClosest;
+				break;
+			}
+			//rounding errors (e.g. on an almost flat tetrahedron) stopped
+			//the progress: the last simplex is as close as it gets
+
+			previous = simplex;
+			previousClosest = closest;
+			previousDistance2 = distance2;
+
+			if (result.iterations >= maxGJKIterations)
+			{
+				break;
+			}
+
+			SupportPoint next = support(a, b, -closest);
+
+			if (distance2 - glm::dot(next.point, closest) <=
+			    gjkTolerance * distance2)
+			{
+				break;
+			}
+			//no support point is closer to the origin: closest is final
+
+			bool duplicate = false;
+
+			for (std::uint32_t i = 0; i < simplex.count; i++)
+			{
+				if (simplex.vertices[i].point == next.point)
+				{
+					duplicate = true;
+				}
+			}
+
+			if (duplicate)
+			{
+				break;
+			}
+
+			simplex.vertices[simplex.count] = next;
+			simplex.count++;
+		}
+
+		result.distance = result.intersecting ? 0.0f : glm::length(closest);
+		result.pointA = glm::vec3(0.0f);
+		result.pointB = glm::vec3(0.0f);
+
+		if (simplex.count < 4)
+		{
+			for (std::uint32_t i = 0; i < simplex.count; i++)
+			{
+				const SupportPoint& vertex = simplex.vertices[i];
+				result.pointA += simplex.weights[i] * vertex.pointA;
+				result.pointB += simplex.weights[i] * vertex.pointB;
+			}
+		}
+
+		result.simplexCount = simplex.count;
+
+		for (std::uint32_t i = 0; i < simplex.count; i++)
+		{
+			result.simplex[i] = simplex.vertices[i];
+		}
+
+		if (cache != nullptr)
+		{
+			cache->count = simplex.count;
+
+			for (std::uint32_t i = 0; i < simplex.count; i++)
+			{
+				cache->localA[i] = a.toLocal(simplex.vertices[i].pointA);
+				cache->localB[i] = b.toLocal(simplex.vertices[i].pointB);
+			}
+		}
+
+		return result;
+	}
+
+	bool computePenetration(const ConvexShape& a, const ConvexShape& b,
+	                        const GJKResult& gjk, PenetrationResult& result)
+	{
+		PhysiccZoneFine;
+
+		SupportPoint vertices[maxEPAVertices];
+		std::uint32_t vertexCount = gjk.simplexCount;
+
+		for (std::uint32_t i = 0; i < vertexCount; i++)
+		{
+			vertices[i] = gjk.simplex[i];
+		}
+
+		static const glm::vec3 axes[6] = {
+			{1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f},
+			{0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f},
+			{0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}
+		};
+
+		//GJK may stop on a point, segment or triangle when the shapes
+		//merely touch: blow the simplex up to a tetrahedron first
+		if (vertexCount == 1)
+		{
+			for (const auto& axis : axes)
+			{
+				SupportPoint point = support(a, b, axis);
+				glm::vec3 offset = point.point - vertices[0].point;
+
+				if (glm::dot(offset, offset) > degenerate)
+				{
+					vertices[vertexCount++] = point;
+					break;
+				}
+			}
+		}
+
+		if (vertexCount == 2)
+		{
+			glm::vec3 line = vertices[1].point - vertices[0].point;
+			glm::vec3 absolute = glm::abs(line);
+			glm::vec3 axis = absolute.x < absolute.y
+				? (absolute.x < absolute.z ? axes[0] : axes[4])
+				: (absolute.y < absolute.z ? axes[2] : axes[4]);
+			glm::vec3 side = glm::cross(line, axis);
+
+			for (float sign : {1.0f, -1.0f})
+			{
+				SupportPoint point = support(a, b, sign * side);
+				glm::vec3 offset = glm::cross(line,
+				                              point.point - vertices[0].point);
+
+				if (glm::dot(offset, offset) > degenerate)
+				{
+					vertices[vertexCount++] = point;
+					break;
+				}
+			}
+		}
+
+		if (vertexCount == 3)
+		{
+			const glm::vec3& origin = vertices[0].point;
+			glm::vec3 normal = glm::cross(vertices[1].point - origin,
+			                              vertices[2].point - origin);
+
+			for (float sign : {1.0f, -1.0f})
+			{
+				SupportPoint point = support(a, b, sign * normal);
+
+				if (std::abs(glm::dot(normal, point.point - origin))
+				    > degenerate)
+				{
+					vertices[vertexCount++] = point;
+					break;
+				}
+			}
+		}
+
+		if (vertexCount < 4)
+		{
+			return false;
+		}
+
+		glm::vec3 inner = 0.25f * (vertices[0].point + vertices[1].point +
+		                           vertices[2].point + vertices[3].point);
+
+		Face faces[maxEPAFaces];
+		std::size_t faceCount = 0;
+		faces[faceCount++] = makeFace(vertices, 0, 1, 2, inner);
+		faces[faceCount++] = makeFace(vertices, 0, 3, 1, inner);
+		faces[faceCount++] = makeFace(vertices, 0, 2, 3, inner);
+		faces[faceCount++] = makeFace(vertices, 1, 3, 2, inner);
+
+		Edge edges[maxEPAEdges];
+		std::size_t closest = 0;
+
+		for (std::uint32_t iteration = 0; ; iteration++)
+		{
+			closest = 0;
+
+			for (std::size_t i = 1; i < faceCount; i++)
+			{
+				if (faces[i].distance < faces[closest].distance)
+				{
+					closest = i;
+				}
+			}
+
+			const Face& face = faces[closest];
+
+			if (face.distance == std::numeric_limits<float>::infinity())
+			{
+				return false;
+			}
+
+			if (iteration >= maxEPAIterations ||
+			    vertexCount == maxEPAVertices)
+			{
+				break;
+			}
+
+			SupportPoint point = support(a, b, face.normal);
+
+			if (glm::dot(point.point, face.normal) - face.distance <=
+			    epaTolerance * std::max(1.0f, face.distance))
+			{
+				break;
+			}
+			//the face is on the boundary of A - B
+
+			std::uint32_t newVertex = vertexCount;
+			vertices[vertexCount++] = point;
+
+			//remove the faces the new vertex sees; the edges that are left
+			//with only one face form the horizon
+			std::size_t edgeCount = 0;
+			std::size_t kept = 0;
+			bool overflow = false;
+
+			for (std::size_t i = 0; i < faceCount; i++)
+			{
+				const Face& current = faces[i];
+				glm::vec3 offset = point.point
+					- vertices[current.vertices[0]].point;
+
+				if (glm::dot(current.normal, offset) <= 0.0f)
+				{
+					faces[kept++] = current;
+					continue;
+				}
+
+				for (std::uint32_t j = 0; j < 3; j++)
+				{
+					Edge edge{current.vertices[j],
+					          current.vertices[(j + 1) % 3]};
+					bool shared = false;
+
+					for (std::size_t k = 0; k < edgeCount; k++)
+					{
+						if (edges[k].from == edge.to
+						    && edges[k].to == edge.from)
+						{
+							edges[k] = edges[--edgeCount];
+							shared = true;
+							break;
+						}
+					}
+
+					if (!shared)
+					{
+						if (edgeCount == maxEPAEdges)
+						{
+							overflow = true;
+							break;
+						}
+
+						edges[edgeCount++] = edge;
+					}
+				}
+			}
+
+			if (overflow || kept + edgeCount > maxEPAFaces)
+			{
+				return false;
+			}
+
+			faceCount = kept;
+
+			for (std::size_t i = 0; i < edgeCount; i++)
+			{
+				faces[faceCount++] = makeFace(vertices, edges[i].from,
+				                              edges[i].to, newVertex, inner);
+			}
+		}
+
+		const Face& face = faces[closest];
+		const SupportPoint& v0 = vertices[face.vertices[0]];
+		const SupportPoint& v1 = vertices[face.vertices[1]];
+		const SupportPoint& v2 = vertices[face.vertices[2]];
+		glm::vec3 weights = barycentric(v0.point, v1.point, v2.point,
+		                                face.normal * face.distance);
+
+		result.normal = face.normal;
+		result.depth = std::max(face.distance, 0.0f);
+		result.pointA = weights.x * v0.pointA + weights.y * v1.pointA +
+		                weights.z * v2.pointA;
+		result.pointB = weights.x * v0.pointB + weights.y * v1.pointB +
+		                weights.z * v2.pointB;
+
+		return true;
+	}
+}
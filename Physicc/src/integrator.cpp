@@ -0,0 +1,176 @@
+/**
+ * @file integrator.cpp
+ * @brief The semi-implicit Euler integrator, batched over SoA body arrays.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* integrator header */
+
+#include "tools/Tracy.hpp"
+
+#include "integrator.hpp"
+#include "profiling.hpp"
+#include "simd.hpp"
+
+#include <cstddef>
+
+namespace Physicc
+{
+	//Both kernels walk the vec3 arrays as flat arrays of 3n floats, which
+	//breaks if GLM pads vec3 (e.g. GLM_FORCE_DEFAULT_ALIGNED_GENTYPES)
+	static_assert(sizeof(glm::vec3) == 3 * sizeof(float),
+	              "glm::vec3 has to be three tightly packed floats");
+
+	namespace
+	{
+		inline void integrateVelocity(float* velocity, float* force,
+		                              float inverseMass, float gravityScale,
+		                              const glm::vec3& gravity, float timestep)
+		{
+			float forceScale = inverseMass * timestep;
+			float gravityFactor = inverseMass > 0.0f
+				? gravityScale * timestep
+				: 0.0f;
+
+			for (int k = 0; k < 3; k++)
+			{
+				velocity[k] += force[k] * forceScale
+					+ gravity[k] * gravityFactor;
+				force[k] = 0.0f;
+			}
+		}
+
+#ifdef PHYSICC_SSE2
+		/**
+		 * @brief Spreads four per-body scalars over the x y z layout of
+		 * four packed vec3s, which takes three registers
+		 */
+		inline void spreadOverVec3s(__m128 values, __m128* spread)
+		{
+			spread[0] = _mm_shuffle_ps(values, values, _MM_SHUFFLE(1, 0, 0, 0));
+			spread[1] = _mm_shuffle_ps(values, values, _MM_SHUFFLE(2, 2, 1, 1));
+			spread[2] = _mm_shuffle_ps(values, values, _MM_SHUFFLE(3, 3, 3, 2));
+		}
+#endif
+	}
+
+	void integrate(BodyStorage& bodies, const glm::vec3& gravity,
+	               float timestep)
+	{
+		ZoneScoped;
+
+		integrateVelocities(bodies, gravity, timestep);
+		integratePositions(bodies, timestep);
+	}
+
+	void integrateVelocities(BodyStorage& bodies, const glm::vec3& gravity,
+	                         float timestep)
+	{
+		PhysiccZoneFine;
+
+		std::size_t count = bodies.getAwakeCount();
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		//glm::vec3 is three tightly packed floats, so each array can be
+		//walked as a flat array of 3n floats
+		float* velocities = &bodies.getVelocities().data()->x;
+		float* forces = &bodies.getForces().data()->x;
+		const float* inverseMasses = bodies.getInverseMasses().data();
+		const float* gravityScales = bodies.getGravityScales().data();
+
+		std::size_t i = 0;
+
+#ifdef PHYSICC_SSE2
+		//Four bodies are twelve floats, i.e. three registers:
+		//  [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3]
+		//so per-body scalars get spread to the same pattern with shuffles,
+		//and gravity is rotated to line up with it
+		__m128 step = _mm_set1_ps(timestep);
+		__m128 zero = _mm_setzero_ps();
+		__m128 gravity0 =
+			_mm_setr_ps(gravity.x, gravity.y, gravity.z, gravity.x);
+		__m128 gravity1 =
+			_mm_setr_ps(gravity.y, gravity.z, gravity.x, gravity.y);
+		__m128 gravity2 =
+			_mm_setr_ps(gravity.z, gravity.x, gravity.y, gravity.z);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 inverseMass = _mm_loadu_ps(inverseMasses + i);
+			__m128 forceScale = _mm_mul_ps(inverseMass, step);
+			__m128 gravityFactor = _mm_and_ps(
+				_mm_cmpgt_ps(inverseMass, zero),
+				_mm_mul_ps(_mm_loadu_ps(gravityScales + i), step));
+			//static bodies get a gravity factor of 0
+
+			__m128 forceScales[3];
+			__m128 gravityFactors[3];
+			spreadOverVec3s(forceScale, forceScales);
+			spreadOverVec3s(gravityFactor, gravityFactors);
+			__m128 gravities[3] = {gravity0, gravity1, gravity2};
+
+			for (std::size_t k = 0; k < 3; k++)
+			{
+				std::size_t offset = 3 * i + 4 * k;
+
+				__m128 velocity = _mm_loadu_ps(velocities + offset);
+				velocity = _mm_add_ps(velocity,
+					_mm_mul_ps(_mm_loadu_ps(forces + offset), forceScales[k]));
+				velocity = _mm_add_ps(velocity,
+					_mm_mul_ps(gravities[k], gravityFactors[k]));
+
+				_mm_storeu_ps(velocities + offset, velocity);
+				_mm_storeu_ps(forces + offset, zero);
+			}
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			integrateVelocity(velocities + 3 * i, forces + 3 * i,
+			                  inverseMasses[i], gravityScales[i], gravity,
+			                  timestep);
+		}
+	}
+
+	void integratePositions(BodyStorage& bodies, float timestep)
+	{
+		PhysiccZoneFine;
+
+		//x += v * timestep is the same for every component, so both arrays
+		//are walked as flat arrays of 3n floats
+		std::size_t count = 3 * bodies.getAwakeCount();
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		float* positions = &bodies.getPositions().data()->x;
+		const float* velocities = &bodies.getVelocities().data()->x;
+
+		std::size_t i = 0;
+
+#ifdef PHYSICC_SSE2
+		__m128 step = _mm_set1_ps(timestep);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 position = _mm_add_ps(_mm_loadu_ps(positions + i),
+				_mm_mul_ps(_mm_loadu_ps(velocities + i), step));
+			_mm_storeu_ps(positions + i, position);
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			positions[i] += velocities[i] * timestep;
+		}
+	}
+}
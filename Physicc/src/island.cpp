@@ -0,0 +1,161 @@
+/**
+ * @file island.cpp
+ * @brief Union-find over the contact graph, to group bodies into islands.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* island header */
+
+#include "tools/Tracy.hpp"
+
+#include "island.hpp"
+#include "profiling.hpp"
+
+namespace Physicc
+{
+	namespace
+	{
+		constexpr std::uint32_t noIsland = ~std::uint32_t(0);
+	}
+
+	/**
+	 * @brief Finds the root of a body's set, halving the path on the way
+	 */
+	std::uint32_t IslandBuilder::find(std::uint32_t body)
+	{
+		while (m_parents[body] != body)
+		{
+			m_parents[body] = m_parents[m_parents[body]];
+			body = m_parents[body];
+		}
+
+		return body;
+	}
+
+	void IslandBuilder::build(const BodyStorage& bodies,
+	                          const ContactBuffer& contacts)
+	{
+		ZoneScoped;
+
+		auto awake = static_cast<std::uint32_t>(bodies.getAwakeCount());
+		const auto& inverseMasses = bodies.getInverseMasses();
+
+		m_parents.resize(awake);
+
+		for (std::uint32_t i = 0; i < awake; i++)
+		{
+			m_parents[i] = i;
+		}
+
+		for (const auto& manifold : contacts)
+		{
+			auto a = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+				static_cast<std::uint32_t>(manifold.first)));
+			auto b = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+				static_cast<std::uint32_t>(manifold.second)));
+
+			if (a >= awake || b >= awake ||
+			    inverseMasses[a] == 0.0f || inverseMasses[b] == 0.0f)
+			{
+				continue;
+			}
+			//only pairs of awake, dynamic bodies join islands
+
+			std::uint32_t rootA = find(a);
+			std::uint32_t rootB = find(b);
+
+			//the smaller index becomes the root, so the islands (and their
+			//order) only depend on the contacts, not on the order of unions
+			if (rootA < rootB)
+			{
+				m_parents[rootB] = rootA;
+			}
+			else if (rootB < rootA)
+			{
+				m_parents[rootA] = rootB;
+			}
+		}
+
+		//number the islands in the order of their roots, and count their
+		//bodies
+		m_islands.clear();
+		m_islandOf.assign(awake, noIsland);
+
+		for (std::uint32_t i = 0; i < awake; i++)
+		{
+			std::uint32_t root = find(i);
+
+			if (m_islandOf[root] == noIsland)
+			{
+				m_islandOf[root] = static_cast<std::uint32_t>(m_islands.size());
+				m_islands.push_back({0, 0, 0, 0});
+			}
+
+			m_islandOf[i] = m_islandOf[root];
+			m_islands[m_islandOf[i]].bodyCount++;
+		}
+
+		//roots always come before the rest of their set, so m_islandOf of
+		//the root is set before any other body of its set reads it
+
+		m_contactIslands.assign(contacts.size(), noIsland);
+
+		for (std::size_t m = 0; m < contacts.size(); m++)
+		{
+			const auto& manifold = contacts[m];
+			auto a = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+				static_cast<std::uint32_t>(manifold.first)));
+			auto b = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+				static_cast<std::uint32_t>(manifold.second)));
+
+			std::uint32_t body = a < awake && inverseMasses[a] != 0.0f ? a : b;
+
+			if (body >= awake)
+			{
+				continue;
+			}
+
+			m_contactIslands[m] = m_islandOf[body];
+			m_islands[m_contactIslands[m]].contactCount++;
+		}
+
+		//turn the counts into ranges, then scatter (a counting sort)
+		std::uint32_t bodyOffset = 0;
+		std::uint32_t contactOffset = 0;
+
+		for (auto& island : m_islands)
+		{
+			island.firstBody = bodyOffset;
+			island.firstContact = contactOffset;
+			bodyOffset += island.bodyCount;
+			contactOffset += island.contactCount;
+			island.bodyCount = 0;
+			island.contactCount = 0;
+		}
+
+		m_bodies.resize(bodyOffset);
+		m_contacts.resize(contactOffset);
+
+		for (std::uint32_t i = 0; i < awake; i++)
+		{
+			auto& island = m_islands[m_islandOf[i]];
+			m_bodies[island.firstBody + island.bodyCount++] = i;
+		}
+
+		for (std::size_t m = 0; m < contacts.size(); m++)
+		{
+			if (m_contactIslands[m] == noIsland)
+			{
+				continue;
+			}
+
+			auto& island = m_islands[m_contactIslands[m]];
+			m_contacts[island.firstContact + island.contactCount++] =
+				static_cast<std::uint32_t>(m);
+		}
+
+		PhysiccPlot("Islands", static_cast<std::int64_t>(m_islands.size()));
+	}
+}
@@ -0,0 +1,632 @@
+/**
+ * @file narrowphase.cpp
+ * @brief Contact generation between pairs of colliders.
+ *
+ * Boxes are tested with the separating axis theorem, and their manifolds
+ * are built by clipping the incident face against the reference face.
+ * Pairs involving spheres are solved in closed form, and pairs involving
+ * convex hulls with GJK and EPA.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* narrowphase header */
+
+#include "tools/Tracy.hpp"
+
+#include "narrowphase.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+
+namespace Physicc
+{
+	namespace
+	{
+		struct OrientedBox
+		{
+			glm::vec3 center;
+			glm::mat3 axes;
+			//columns are the local axes in world space
+			glm::vec3 halfExtents;
+		};
+
+		inline OrientedBox toOrientedBox(const Collider& collider)
+		{
+			const auto& box = static_cast<const BoxCollider&>(collider);
+
+			return {box.getCentroid(), box.getRotationMatrix(),
+			        box.getHalfExtents()};
+		}
+
+		struct ClipVertex
+		{
+			glm::vec3 position;
+			std::uint32_t feature;
+		};
+
+		constexpr int maxClipVertices = 8;
+		//a quad clipped by four planes has at most eight vertices
+
+		/**
+		 * @brief Clips a polygon against the plane dot(normal, x) <= offset
+		 * (Sutherland-Hodgman)
+		 *
+		 * @return The number of vertices written to out
+		 */
+		int clipPolygon(const ClipVertex* in, int count,
+		                const glm::vec3& normal, float offset,
+		                std::uint32_t plane, ClipVertex* out)
+		{
+			int outCount = 0;
+
+			for (int i = 0; i < count; i++)
+			{
+				const ClipVertex& from = in[i];
+				const ClipVertex& to = in[(i + 1) % count];
+
+				float distanceFrom = glm::dot(normal, from.position) - offset;
+				float distanceTo = glm::dot(normal, to.position) - offset;
+
+				if (distanceFrom <= 0.0f)
+				{
+					out[outCount++] = from;
+				}
+
+				if ((distanceFrom <= 0.0f) != (distanceTo <= 0.0f))
+				{
+					//the edge crosses the plane; the new vertex is named after
+					//the edge and the plane that made it
+					float t = distanceFrom / (distanceFrom - distanceTo);
+					out[outCount++] = {glm::mix(from.position, to.position, t),
+					                   ((from.feature * 31u + to.feature) * 8u
+					                    + plane + 1u) & 0xffffu};
+				}
+			}
+
+			return outCount;
+		}
+
+		/**
+		 * @brief Keeps the four points that span the largest area, starting
+		 * from the deepest one
+		 *
+		 * Four well spread points are enough for a stable face contact, and
+		 * keep the solver's work per manifold bounded.
+		 */
+		void reducePoints(ContactManifold& manifold, const ContactPoint* points,
+		                  int count)
+		{
+			auto area = [&](int a, int b, int c) {
+				glm::vec3 ab = points[b].position - points[a].position;
+				glm::vec3 ac = points[c].position - points[a].position;
+
+				return glm::dot(manifold.normal, glm::cross(ab, ac));
+			};
+
+			int first = 0;
+
+			for (int i = 1; i < count; i++)
+			{
+				if (points[i].penetration > points[first].penetration)
+				{
+					first = i;
+				}
+			}
+
+			int second = first == 0 ? 1 : 0;
+
+			const glm::vec3& origin = points[first].position;
+
+			for (int i = 0; i < count; i++)
+			{
+				glm::vec3 offset = points[i].position - origin;
+				glm::vec3 best = points[second].position - origin;
+
+				if (glm::dot(offset, offset) > glm::dot(best, best))
+				{
+					second = i;
+				}
+			}
+
+			int third = -1;
+			float thirdArea = 0.0f;
+
+			for (int i = 0; i < count; i++)
+			{
+				if (std::abs(area(first, second, i)) > std::abs(thirdArea))
+				{
+					third = i;
+					thirdArea = area(first, second, i);
+				}
+			}
+
+			//the fourth point goes on the other side of the first edge
+			int fourth = -1;
+			float fourthArea = 0.0f;
+
+			for (int i = 0; third != -1 && i < count; i++)
+			{
+				float candidate = area(first, second, i);
+
+				if (candidate * thirdArea < 0.0f
+				    && std::abs(candidate) > std::abs(fourthArea))
+				{
+					fourth = i;
+					fourthArea = candidate;
+				}
+			}
+
+			manifold.pointCount = 0;
+
+			for (int index : {first, second, third, fourth})
+			{
+				if (index != -1)
+				{
+					manifold.points[manifold.pointCount++] = points[index];
+				}
+			}
+		}
+
+		/**
+		 * @brief Builds a face contact by clipping the incident face of one
+		 * box against the side planes of the reference face of the other
+		 *
+		 * @param normal Normal of the reference face, pointing towards the
+		 * incident box
+		 * @return The number of contact points, written to points
+		 */
+		int clipFaces(const OrientedBox& reference, int axis,
+		              const glm::vec3& normal, const OrientedBox& incident,
+		              std::uint32_t featureBase, ContactPoint* points)
+		{
+			glm::vec3 faceCenter = reference.center
+				+ normal * reference.halfExtents[axis];
+
+			//The incident face is the one most anti-parallel to the normal
+			int incidentAxis = 0;
+			float bestDot = 0.0f;
+
+			for (int k = 0; k < 3; k++)
+			{
+				float d = std::abs(glm::dot(incident.axes[k], normal));
+
+				if (d > bestDot)
+				{
+					bestDot = d;
+					incidentAxis = k;
+				}
+			}
+
+			float side = glm::dot(incident.axes[incidentAxis], normal) > 0.0f
+				? -1.0f
+				: 1.0f;
+			glm::vec3 incidentCenter = incident.center
+				+ incident.axes[incidentAxis]
+				* (side * incident.halfExtents[incidentAxis]);
+			glm::vec3 p = incident.axes[(incidentAxis + 1) % 3]
+				* incident.halfExtents[(incidentAxis + 1) % 3];
+			glm::vec3 q = incident.axes[(incidentAxis + 2) % 3]
+				* incident.halfExtents[(incidentAxis + 2) % 3];
+
+			ClipVertex buffers[2][maxClipVertices] = {{
+				{incidentCenter + p + q, 0},
+				{incidentCenter - p + q, 1},
+				{incidentCenter - p - q, 2},
+				{incidentCenter + p - q, 3}
+			}};
+			int count = 4;
+			int current = 0;
+
+			int u = (axis + 1) % 3;
+			int v = (axis + 2) % 3;
+			glm::vec3 planes[4] = {reference.axes[u], -reference.axes[u],
+			                       reference.axes[v], -reference.axes[v]};
+			float extents[4] = {reference.halfExtents[u],
+			                    reference.halfExtents[u],
+			                    reference.halfExtents[v],
+			                    reference.halfExtents[v]};
+
+			for (std::uint32_t plane = 0; plane < 4 && count > 0; plane++)
+			{
+				float offset = glm::dot(planes[plane], faceCenter)
+					+ extents[plane];
+				count = clipPolygon(buffers[current], count, planes[plane],
+				                    offset, plane, buffers[1 - current]);
+				current = 1 - current;
+			}
+
+			//Keep the points below the reference face
+			int pointCount = 0;
+
+			for (int i = 0; i < count; i++)
+			{
+				const ClipVertex& vertex = buffers[current][i];
+				float distance = glm::dot(normal, vertex.position - faceCenter);
+
+				if (distance <= 0.0f)
+				{
+					glm::vec3 midpoint = vertex.position
+						- normal * (0.5f * distance);
+					points[pointCount++] = {midpoint, -distance,
+					                        featureBase | vertex.feature};
+				}
+			}
+
+			return pointCount;
+		}
+
+		/**
+		 * @brief Returns the closest points between two segments, given by
+		 * their centers, unit directions and half lengths
+		 */
+		void closestPoints(const glm::vec3& centerA,
+		                   const glm::vec3& directionA, float extentA,
+		                   const glm::vec3& centerB,
+		                   const glm::vec3& directionB, float extentB,
+		                   glm::vec3& pointA, glm::vec3& pointB)
+		{
+			glm::vec3 offset = centerA - centerB;
+			float b = glm::dot(directionA, directionB);
+			float c = glm::dot(directionA, offset);
+			float f = glm::dot(directionB, offset);
+			float denominator = 1.0f - b * b;
+
+			float s = denominator > std::numeric_limits<float>::epsilon()
+				? std::clamp((b * f - c) / denominator, -extentA, extentA)
+				: 0.0f;
+			float t = std::clamp(b * s + f, -extentB, extentB);
+			s = std::clamp(b * t - c, -extentA, extentA);
+
+			pointA = centerA + directionA * s;
+			pointB = centerB + directionB * t;
+		}
+	}
+
+	const Narrowphase::ContactFunction Narrowphase::s_dispatch
+		[Collider::e_typecount][Collider::e_typecount] = {
+			{&Narrowphase::boxBox, &Narrowphase::boxSphere,
+			 &Narrowphase::convexConvex, &Narrowphase::convexConvex},
+			{&Narrowphase::sphereBox, &Narrowphase::sphereSphere,
+			 &Narrowphase::convexConvex, &Narrowphase::convexConvex},
+			{&Narrowphase::convexConvex, &Narrowphase::convexConvex,
+			 &Narrowphase::convexConvex, &Narrowphase::convexConvex},
+			{&Narrowphase::convexConvex, &Narrowphase::convexConvex,
+			 &Narrowphase::convexConvex, &Narrowphase::convexConvex}
+		};
+	//indexed [type of a][type of b], in the order of Collider::Type
+
+	bool Narrowphase::collide(const Collider& a, const Collider& b,
+	                          ContactManifold& manifold)
+	{
+		PhysiccZoneFine;
+
+		return (this->*s_dispatch[a.getType()][b.getType()])(a, b, manifold);
+	}
+
+	void Narrowphase::pruneCache()
+	{
+		PhysiccZoneFine;
+
+		for (auto it = m_simplexCache.begin(); it != m_simplexCache.end();)
+		{
+			if (it->second.used)
+			{
+				it->second.used = false;
+				++it;
+			}
+			else
+			{
+				it = m_simplexCache.erase(it);
+			}
+		}
+	}
+
+	/**
+	 * @brief Box-box contacts, from the separating axis theorem
+	 *
+	 * All 15 candidate axes (3 face normals of each box and the 9 cross
+	 * products of their edges) are tested. If none separates the boxes, the
+	 * axis of least penetration decides the contact: a face axis gives a
+	 * face contact, built by clipping, and an edge axis gives a single
+	 * point between the two closest edges. Face axes are favoured over
+	 * edge axes that are only marginally better, which keeps resting
+	 * contacts from flickering between the two.
+	 */
+	bool Narrowphase::boxBox(const Collider& a, const Collider& b,
+	                         ContactManifold& manifold)
+	{
+		OrientedBox boxA = toOrientedBox(a);
+		OrientedBox boxB = toOrientedBox(b);
+		glm::vec3 offset = boxB.center - boxA.center;
+
+		auto radius = [](const OrientedBox& box, const glm::vec3& axis) {
+			return box.halfExtents.x * std::abs(glm::dot(box.axes[0], axis))
+				+ box.halfExtents.y * std::abs(glm::dot(box.axes[1], axis))
+				+ box.halfExtents.z * std::abs(glm::dot(box.axes[2], axis));
+		};
+
+		//Separations are negative when the boxes overlap along the axis
+		float faceSeparation = -std::numeric_limits<float>::infinity();
+		int faceAxis = 0;
+		glm::vec3 faceNormal(0.0f);
+
+		for (int i = 0; i < 6; i++)
+		{
+			glm::vec3 axis = i < 3 ? boxA.axes[i] : boxB.axes[i - 3];
+			float distance = glm::dot(offset, axis);
+			float separation = std::abs(distance) - radius(boxA, axis)
+				- radius(boxB, axis);
+
+			if (separation > 0.0f)
+			{
+				return false;
+			}
+
+			if (separation > faceSeparation)
+			{
+				faceSeparation = separation;
+				faceAxis = i;
+				faceNormal = distance < 0.0f ? -axis : axis;
+			}
+		}
+
+		float edgeSeparation = -std::numeric_limits<float>::infinity();
+		int edgeAxis = -1;
+		glm::vec3 edgeNormal(0.0f);
+
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				glm::vec3 axis = glm::cross(boxA.axes[i], boxB.axes[j]);
+				float length = glm::length(axis);
+
+				if (length < 1e-5f)
+				{
+					continue;
+					//parallel edges, already covered by the face axes
+				}
+
+				axis /= length;
+				float distance = glm::dot(offset, axis);
+				float separation = std::abs(distance) - radius(boxA, axis)
+					- radius(boxB, axis);
+
+				if (separation > 0.0f)
+				{
+					return false;
+				}
+
+				if (separation > edgeSeparation)
+				{
+					edgeSeparation = separation;
+					edgeAxis = 3 * i + j;
+					edgeNormal = distance < 0.0f ? -axis : axis;
+				}
+			}
+		}
+
+		constexpr float relativeTolerance = 0.95f;
+		constexpr float absoluteTolerance = 0.01f;
+
+		if (edgeAxis != -1
+		    && edgeSeparation
+		       > relativeTolerance * faceSeparation + absoluteTolerance)
+		{
+			int i = edgeAxis / 3;
+			int j = edgeAxis % 3;
+			manifold.normal = edgeNormal;
+
+			//The supporting edges: the edge of a furthest along the normal,
+			//and the edge of b furthest against it
+			glm::vec3 edgeA = boxA.center;
+			glm::vec3 edgeB = boxB.center;
+
+			for (int k = 0; k < 3; k++)
+			{
+				if (k != i)
+				{
+					float side = glm::dot(boxA.axes[k], edgeNormal) > 0.0f
+						? 1.0f
+						: -1.0f;
+					edgeA += boxA.axes[k] * (side * boxA.halfExtents[k]);
+				}
+
+				if (k != j)
+				{
+					float side = glm::dot(boxB.axes[k], edgeNormal) > 0.0f
+						? -1.0f
+						: 1.0f;
+					edgeB += boxB.axes[k] * (side * boxB.halfExtents[k]);
+				}
+			}
+
+			glm::vec3 pointA, pointB;
+			closestPoints(edgeA, boxA.axes[i], boxA.halfExtents[i],
+			              edgeB, boxB.axes[j], boxB.halfExtents[j],
+			              pointA, pointB);
+
+			manifold.pointCount = 1;
+			auto feature = static_cast<std::uint32_t>(6 + edgeAxis) << 16;
+			manifold.points[0] = {0.5f * (pointA + pointB), -edgeSeparation,
+			                      feature};
+
+			return true;
+		}
+
+		manifold.normal = faceNormal;
+
+		ContactPoint points[maxClipVertices];
+		auto featureBase = static_cast<std::uint32_t>(faceAxis) << 16;
+		int count = faceAxis < 3
+			? clipFaces(boxA, faceAxis, faceNormal, boxB, featureBase,
+			            points)
+			: clipFaces(boxB, faceAxis - 3, -faceNormal, boxA, featureBase,
+			            points);
+
+		if (count == 0)
+		{
+			return false;
+			//only grazing, within rounding error
+		}
+
+		if (count <= static_cast<int>(ContactManifold::maxPoints))
+		{
+			manifold.pointCount = static_cast<std::uint32_t>(count);
+			std::copy(points, points + count, manifold.points);
+		} else
+		{
+			reducePoints(manifold, points, count);
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief Box-sphere contacts
+	 *
+	 * The sphere's center is brought into the box's local frame and clamped
+	 * to the box, which gives the closest point of the box. If the center is
+	 * inside the box, the contact is pushed out through the nearest face.
+	 */
+	bool Narrowphase::boxSphere(const Collider& a, const Collider& b,
+	                            ContactManifold& manifold)
+	{
+		OrientedBox box = toOrientedBox(a);
+		const auto& sphere = static_cast<const SphereCollider&>(b);
+		glm::vec3 center = sphere.getCentroid();
+		float radius = sphere.getRadius();
+
+		glm::vec3 local = glm::transpose(box.axes) * (center - box.center);
+		glm::vec3 closest = glm::clamp(local, -box.halfExtents,
+		                               box.halfExtents);
+		glm::vec3 normal(0.0f);
+		float penetration;
+
+		if (local != closest)
+		{
+			glm::vec3 offset = local - closest;
+			float distanceSquared = glm::dot(offset, offset);
+
+			if (distanceSquared > radius * radius)
+			{
+				return false;
+			}
+
+			float distance = std::sqrt(distanceSquared);
+			normal = offset / distance;
+			penetration = radius - distance;
+		} else
+		{
+			glm::vec3 depth = box.halfExtents - glm::abs(local);
+			int axis = depth.x < depth.y
+				? (depth.x < depth.z ? 0 : 2)
+				: (depth.y < depth.z ? 1 : 2);
+
+			normal[axis] = local[axis] < 0.0f ? -1.0f : 1.0f;
+			closest[axis] = normal[axis] * box.halfExtents[axis];
+			penetration = radius + depth[axis];
+		}
+
+		manifold.normal = box.axes * normal;
+		glm::vec3 onBox = box.center + box.axes * closest;
+		glm::vec3 onSphere = center - manifold.normal * radius;
+
+		manifold.pointCount = 1;
+		manifold.points[0] = {0.5f * (onBox + onSphere), penetration, 0};
+
+		return true;
+	}
+
+	bool Narrowphase::sphereBox(const Collider& a, const Collider& b,
+	                            ContactManifold& manifold)
+	{
+		if (!boxSphere(b, a, manifold))
+		{
+			return false;
+		}
+
+		manifold.normal = -manifold.normal;
+		//the normal must point from a (the sphere) to b (the box)
+
+		return true;
+	}
+
+	bool Narrowphase::sphereSphere(const Collider& a, const Collider& b,
+	                               ContactManifold& manifold)
+	{
+		const auto& sphereA = static_cast<const SphereCollider&>(a);
+		const auto& sphereB = static_cast<const SphereCollider&>(b);
+
+		glm::vec3 offset = sphereB.getCentroid() - sphereA.getCentroid();
+		float radii = sphereA.getRadius() + sphereB.getRadius();
+		float distanceSquared = glm::dot(offset, offset);
+
+		if (distanceSquared > radii * radii)
+		{
+			return false;
+		}
+
+		float distance = std::sqrt(distanceSquared);
+		manifold.normal = distance > std::numeric_limits<float>::epsilon()
+			? offset / distance
+			: glm::vec3(0.0f, 1.0f, 0.0f);
+		//concentric spheres can be pushed apart along any axis
+
+		glm::vec3 onA = sphereA.getCentroid()
+			+ manifold.normal * sphereA.getRadius();
+		glm::vec3 onB = sphereB.getCentroid()
+			- manifold.normal * sphereB.getRadius();
+
+		manifold.pointCount = 1;
+		manifold.points[0] = {0.5f * (onA + onB), radii - distance, 0};
+
+		return true;
+	}
+
+	/**
+	 * @brief Contacts between any two convex shapes, from GJK and EPA
+	 *
+	 * EPA only finds the deepest point of the overlap, so the manifold has a
+	 * single point. Its feature id is always 0: the point is matched with
+	 * last frame's by the pair alone.
+	 */
+	bool Narrowphase::convexConvex(const Collider& a, const Collider& b,
+	                               ContactManifold& manifold)
+	{
+		PhysiccZoneFine;
+
+		ConvexShape shapeA = ConvexShape::fromCollider(a);
+		ConvexShape shapeB = ConvexShape::fromCollider(b);
+
+		std::uint64_t key = (static_cast<std::uint64_t>(manifold.first) << 32) |
+		                    static_cast<std::uint32_t>(manifold.second);
+		auto& cached = m_simplexCache[key];
+		cached.used = true;
+
+		GJKResult gjk = computeDistance(shapeA, shapeB, &cached.simplex);
+
+		if (!gjk.intersecting)
+		{
+			return false;
+		}
+
+		PenetrationResult penetration;
+
+		if (!computePenetration(shapeA, shapeB, gjk, penetration))
+		{
+			return false;
+		}
+
+		manifold.normal = penetration.normal;
+		manifold.pointCount = 1;
+		manifold.points[0] = {0.5f * (penetration.pointA + penetration.pointB),
+		                      penetration.depth, 0};
+
+		return true;
+	}
+}
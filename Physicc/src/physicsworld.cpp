@@ -17,6 +17,10 @@
 #include "tools/Tracy.hpp"
 
 #include "physicsworld.hpp"
+#include "integrator.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 namespace Physicc
 {
@@ -25,37 +29,462 @@ namespace Physicc
 	 *
 	 * This initialises the Physics World with gravity, input from the ---?---.
 	 */
-	PhysicsWorld::PhysicsWorld(const glm::vec3& gravity)
-		: m_gravity(gravity)    
+	PhysicsWorld::PhysicsWorld(const glm::vec3& gravity,
+	                           Broadphase::Type broadphase)
+		: m_gravity(gravity),
+			m_fixedTimestep(1.0f / 60.0f),
+			m_accumulator(0.0f),
+			m_maxSubsteps(8),
+			m_broadphase(Broadphase::create(broadphase)),
+			m_threads(std::make_unique<ThreadPool>()),
+			m_sleepThreshold(0.05f),
+			m_timeToSleep(0.5f)
 	{
 	}
 
+	void PhysicsWorld::setThreadCount(std::size_t threads)
+	{
+		m_threads = std::make_unique<ThreadPool>(threads > 0 ? threads - 1 : 0);
+	}
+
+	void PhysicsWorld::setBroadphase(Broadphase::Type type)
+	{
+		ZoneScoped;
+
+		m_broadphase = Broadphase::create(type);
+
+		for (std::size_t i = 0; i < m_bodies.size(); i++)
+		{
+			m_broadphase->insert(m_bodies.getSlot(i),
+			                     m_bodies.getCollider(i).getAABB());
+		}
+	}
+
 	/**
-	 * @fn void PhysicsWorld::addRigidBody(const RigidBody& object)
-	 * @brief Add a new RigidBody to m_objects
+	 * @fn BodyHandle PhysicsWorld::addRigidBody(const RigidBody& object)
+	 * @brief Add a new RigidBody to the world
 	 * @param object: input, const RigidBody& type
+	 * @return A handle to the body, which stays valid until it is removed
+	 */
+	BodyHandle PhysicsWorld::addRigidBody(const RigidBody& object)
+	{
+		PhysiccZoneFine;
+
+		BodyHandle handle = m_bodies.add(object);
+		std::size_t index = m_bodies.getIndex(handle);
+		m_broadphase->insert(handle.index,
+		                     m_bodies.getCollider(index).getAABB());
+
+		return handle;
+	}
+
+	void PhysicsWorld::removeRigidBody(BodyHandle handle)
+	{
+		PhysiccZoneFine;
+
+		m_broadphase->remove(handle.index);
+		m_bodies.remove(handle);
+	}
+
+	/**
+	 * @brief Moves the colliders to the new positions of the bodies, and
+	 * hands their new AABBs to the broadphase, which then collects the pairs
+	 * of bodies that may be colliding
+	 *
+	 * Sleeping bodies don't move, so only the awake ones are updated.
+	 *
+	 * CCD bodies that are about to move further than their swept sphere's
+	 * radius get the AABB swept along that move instead, so that the pairs
+	 * include everything they may hit during the step.
+	 */
+	void PhysicsWorld::updateBroadphase(float timestep)
+	{
+		ZoneScoped;
+
+		const auto& velocities = m_bodies.getVelocities();
+		const auto& forces = m_bodies.getForces();
+		const auto& inverseMasses = m_bodies.getInverseMasses();
+		const auto& gravityScales = m_bodies.getGravityScales();
+		const auto& radii = m_bodies.getCCDRadii();
+
+		m_bodies.updateColliders(m_volumes);
+
+		for (std::size_t i = 0; i < m_bodies.getAwakeCount(); i++)
+		{
+			BoundingVolume::AABB volume = m_volumes[i];
+
+			if (radii[i] > 0.0f)
+			{
+				//the velocity the body is about to be integrated with,
+				//before contacts change it
+				glm::vec3 acceleration = forces[i] * inverseMasses[i];
+
+				if (inverseMasses[i] > 0.0f)
+				{
+					acceleration += m_gravity * gravityScales[i];
+				}
+
+				glm::vec3 motion = (velocities[i] + acceleration * timestep) *
+				                   timestep;
+
+				if (glm::dot(motion, motion) > radii[i] * radii[i])
+				{
+					BoundingVolume::AABB swept(volume.getLowerBound() + motion,
+					                           volume.getUpperBound() + motion);
+					volume = volume.enclosingBV(swept);
+				}
+			}
+
+			m_broadphase->update(m_bodies.getSlot(i), volume);
+		}
+
+		m_broadphase->findPairs(m_pairs);
+	}
+
+	/**
+	 * @brief Runs the narrowphase on every pair found by the broadphase
+	 *
+	 * The contact buffer is sized for the worst case (every pair touching)
+	 * up front, so it is never reallocated while being filled.
+	 *
+	 * Pairs of sleeping bodies are skipped. A sleeping body touched by an
+	 * awake one wakes up along with its island, and the skipped pairs that
+	 * involve the woken bodies are then collided after all.
+	 */
+	void PhysicsWorld::updateContacts()
+	{
+		ZoneScoped;
+
+		m_contacts.reset(m_pairs.size());
+		m_sleepingPairs.clear();
+
+		const auto& inverseMasses = m_bodies.getInverseMasses();
+
+		auto collide = [&](const CollisionPair& pair, bool& woke)
+		{
+			auto first = static_cast<std::uint32_t>(pair.first);
+			auto second = static_cast<std::uint32_t>(pair.second);
+			std::size_t a = m_bodies.getIndexOfSlot(first);
+			std::size_t b = m_bodies.getIndexOfSlot(second);
+
+			if (inverseMasses[a] == 0.0f && inverseMasses[b] == 0.0f)
+			{
+				return;
+			}
+
+			auto& manifold = m_contacts.next();
+			manifold.first = pair.first;
+			manifold.second = pair.second;
+
+			if (!m_narrowphase.collide(m_bodies.getCollider(a),
+			                           m_bodies.getCollider(b), manifold))
+			{
+				return;
+			}
+
+			m_contacts.commit();
+
+			//static bodies are never woken by contacts, they don't react
+			//to them anyway
+			if (!m_bodies.isAwake(a) && inverseMasses[a] != 0.0f)
+			{
+				m_bodies.wake(first);
+				woke = true;
+			}
+
+			if (!m_bodies.isAwake(b) && inverseMasses[b] != 0.0f)
+			{
+				m_bodies.wake(second);
+				woke = true;
+			}
+		};
+
+		bool woke = false;
+
+		for (std::size_t i = 0; i < m_pairs.size(); i++)
+		{
+			const auto& pair = m_pairs[i];
+
+			if (!m_bodies.isAwake(m_bodies.getIndexOfSlot(
+			        static_cast<std::uint32_t>(pair.first))) &&
+			    !m_bodies.isAwake(m_bodies.getIndexOfSlot(
+			        static_cast<std::uint32_t>(pair.second))))
+			{
+				m_sleepingPairs.push_back(i);
+				continue;
+			}
+
+			collide(pair, woke);
+		}
+
+		if (woke)
+		{
+			bool ignored = false;
+
+			for (std::size_t i : m_sleepingPairs)
+			{
+				const auto& pair = m_pairs[i];
+
+				if (m_bodies.isAwake(m_bodies.getIndexOfSlot(
+				        static_cast<std::uint32_t>(pair.first))) ||
+				    m_bodies.isAwake(m_bodies.getIndexOfSlot(
+				        static_cast<std::uint32_t>(pair.second))))
+				{
+					collide(pair, ignored);
+				}
+			}
+		}
+
+		m_narrowphase.pruneCache();
+
+		PhysiccPlot("Narrowphase manifolds",
+		            static_cast<std::int64_t>(m_contacts.size()));
+	}
+
+	/**
+	 * @brief Stops fast CCD bodies where they first hit something during
+	 * the step
+	 *
+	 * Runs after the bodies moved, while the colliders are still where
+	 * the step started. Each CCD body that moved further than its swept
+	 * sphere's radius (and so could have skipped over something) is swept
+	 * against the other body of each of its pairs, relative to that
+	 * body's own motion. Bodies that hit something are put back at the
+	 * earliest impact, slightly into the body hit, with their velocity
+	 * kept: the next step's contacts then stop or bounce them.
 	 */
-	void PhysicsWorld::addRigidBody(const RigidBody& object)
+	void PhysicsWorld::updateContinuous()
 	{
 		ZoneScoped;
 
-		m_objects.push_back(object);
+		constexpr float impactDepth = 0.01f;
+		//left between the bodies, so that the narrowphase sees them touch
+
+		auto& positions = m_bodies.getPositions();
+		const auto& radii = m_bodies.getCCDRadii();
+
+		m_sweeps.clear();
+
+		for (std::size_t i = 0; i < m_bodies.getAwakeCount(); i++)
+		{
+			if (radii[i] == 0.0f)
+			{
+				continue;
+			}
+
+			glm::vec3 displacement = positions[i] -
+			                         m_bodies.getCollider(i).getPosition();
+
+			if (glm::dot(displacement, displacement) > radii[i] * radii[i])
+			{
+				m_sweeps.push_back({static_cast<std::uint32_t>(i), displacement,
+				                    {1.0f, glm::vec3(0.0f), glm::vec3(0.0f)},
+				                    glm::vec3(0.0f)});
+			}
+		}
+
+		if (m_sweeps.empty())
+		{
+			return;
+		}
+
+		m_sweepOfSlot.assign(m_bodies.getSlotCount(), BodyHandle::nullIndex);
+
+		for (std::size_t i = 0; i < m_sweeps.size(); i++)
+		{
+			m_sweepOfSlot[m_bodies.getSlot(m_sweeps[i].index)] =
+				static_cast<std::uint32_t>(i);
+		}
+
+		auto sweep = [&](std::size_t sweepSlot, std::size_t targetSlot)
+		{
+			std::uint32_t s = m_sweepOfSlot[sweepSlot];
+
+			if (s == BodyHandle::nullIndex)
+			{
+				return;
+			}
+
+			Sweep& body = m_sweeps[s];
+			std::size_t target = m_bodies.getIndexOfSlot(
+				static_cast<std::uint32_t>(targetSlot));
+			const auto& collider = m_bodies.getCollider(target);
+			glm::vec3 targetDisplacement = positions[target] -
+			                               collider.getPosition();
+			TimeOfImpact impact;
+
+			if (sweepSphere(m_bodies.getCollider(body.index).getPosition(),
+			                radii[body.index],
+			                body.displacement - targetDisplacement, collider,
+			                impact) &&
+			    impact.t < body.impact.t)
+			{
+				body.impact = impact;
+				body.targetDisplacement = targetDisplacement;
+			}
+		};
+
+		for (const auto& pair : m_pairs)
+		{
+			sweep(pair.first, pair.second);
+			sweep(pair.second, pair.first);
+		}
+
+		for (const auto& body : m_sweeps)
+		{
+			if (body.impact.t >= 1.0f)
+			{
+				continue;
+			}
+
+			glm::vec3 start = m_bodies.getCollider(body.index).getPosition();
+			glm::vec3 relative = body.displacement - body.targetDisplacement;
+			positions[body.index] = start + body.impact.t * relative
+				- body.impact.normal * impactDepth + body.targetDisplacement;
+		}
+
+		PhysiccPlot("CCD sweeps", static_cast<std::int64_t>(m_sweeps.size()));
+	}
+
+	/**
+	 * @brief Puts to sleep the islands whose bodies all rested long enough
+	 *
+	 * A body rests while its speed stays under the sleep threshold. Islands
+	 * sleep as a whole, since a body can't rest while something it touches
+	 * still moves. The islands are the ones built for the solver.
+	 */
+	void PhysicsWorld::updateSleep(float timestep)
+	{
+		ZoneScoped;
+
+		const auto& velocities = m_bodies.getVelocities();
+		auto& sleepTimes = m_bodies.getSleepTimes();
+		float threshold = m_sleepThreshold * m_sleepThreshold;
+
+		for (std::size_t i = 0; i < m_bodies.getAwakeCount(); i++)
+		{
+			sleepTimes[i] = glm::dot(velocities[i], velocities[i]) > threshold
+				? 0.0f
+				: sleepTimes[i] + timestep;
+		}
+
+		//collect the slots of every island to put to sleep first, since
+		//putting an island to sleep reorders the dense indices
+		m_sleepingSlots.clear();
+		m_sleepingSizes.clear();
+
+		const auto& islandBodies = m_islands.getBodies();
+
+		for (const auto& island : m_islands.getIslands())
+		{
+			const std::uint32_t* first = islandBodies.data() + island.firstBody;
+			const std::uint32_t* last = first + island.bodyCount;
+
+			if (std::any_of(first, last, [&](std::uint32_t body)
+			                {
+			                	return sleepTimes[body] < m_timeToSleep;
+			                }))
+			{
+				continue;
+			}
+
+			for (const std::uint32_t* body = first; body != last; body++)
+			{
+				m_sleepingSlots.push_back(m_bodies.getSlot(*body));
+			}
+
+			m_sleepingSizes.push_back(island.bodyCount);
+		}
+
+		std::size_t offset = 0;
+
+		for (std::size_t size : m_sleepingSizes)
+		{
+			m_bodies.sleep(m_sleepingSlots.data() + offset, size);
+			offset += size;
+		}
+
+		PhysiccPlot("Awake bodies",
+		            static_cast<std::int64_t>(m_bodies.getAwakeCount()));
 	}
 
 	/**
 	 * @fn void PhysicsWorld::stepSimulation(float time)
 	 * @brief steps the simulation by time timestep
 	 * @param timestep: input, float type, time interval
+	 *
+	 * Contacts are found at the current positions, then the velocities are
+	 * integrated and corrected by the solver, and only then are the bodies
+	 * moved, so that they never move into each other. Fast CCD bodies are
+	 * then pulled back to their first impact.
 	 */
 	void PhysicsWorld::stepSimulation(float timestep)
 	{
 		ZoneScoped;
 
-		(void)timestep; // Suppress unused parameter warning
-		for(std::size_t i = 0; i < m_objects.size(); i++)
+		updateBroadphase(timestep);
+		updateContacts();
+		m_islands.build(m_bodies, m_contacts);
+		integrateVelocities(m_bodies, m_gravity, timestep);
+		m_solver.solve(m_bodies, m_contacts, m_islands, timestep, *m_threads);
+		integratePositions(m_bodies, timestep);
+		updateContinuous();
+		updateSleep(timestep);
+	}
+
+	int PhysicsWorld::update(float frameTime)
+	{
+		ZoneScoped;
+
+		//with assertions disabled, a bad timestep would otherwise divide by
+		//0, or never consume the accumulator
+		if (!(m_fixedTimestep > 0.0f))
+		{
+			return 0;
+		}
+
+		m_accumulator += frameTime;
+
+		int steps = static_cast<int>(m_accumulator / m_fixedTimestep);
+
+		if (steps > m_maxSubsteps)
+		{
+			//drop the whole steps we can't afford, but keep the fraction
+			//of a step so the interpolation alpha stays continuous
+			steps = m_maxSubsteps;
+			m_accumulator = std::fmod(m_accumulator, m_fixedTimestep)
+				+ static_cast<float>(steps) * m_fixedTimestep;
+		}
+
+		for (int i = 0; i < steps; i++)
 		{
+			if (i == steps - 1)
+			{
+				//only the last step is interpolated from. Sleeping bodies
+				//don't move, and their previous positions were set when
+				//they fell asleep.
+				std::copy_n(m_bodies.getPositions().begin(),
+				            m_bodies.getAwakeCount(),
+				            m_bodies.getPreviousPositions().begin());
+			}
 
+			stepSimulation(m_fixedTimestep);
+			m_accumulator -= m_fixedTimestep;
 		}
+
+		//rounding can leave the accumulator a hair outside of [0, step)
+		m_accumulator = std::clamp(m_accumulator, 0.0f,
+		                           std::nextafter(m_fixedTimestep, 0.0f));
+
+		return steps;
 	}
-}
 
+	glm::vec3 PhysicsWorld::getInterpolatedPosition(BodyHandle handle) const
+	{
+		std::size_t index = m_bodies.getIndex(handle);
+
+		return glm::mix(m_bodies.getPreviousPositions()[index],
+		                m_bodies.getPositions()[index],
+		                getInterpolationAlpha());
+	}
+}
@@ -23,7 +23,10 @@ namespace Physicc
 		:	m_force(glm::vec3(0)),
 			m_mass(mass),
 			m_velocity(velocity),
-			m_gravityScale(gravityScale)
+			m_gravityScale(gravityScale),
+			m_friction(0.5f),
+			m_restitution(0.0f),
+			m_ccd(false)
 	{
 	}
 }
@@ -0,0 +1,557 @@
+/**
+ * @file solver.cpp
+ * @brief Sequential impulse contact solver, with friction, restitution and
+ * warm starting, solved in parallel over islands and colors.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* solver header */
+
+#include "tools/Tracy.hpp"
+
+#include "solver.hpp"
+#include "profiling.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Physicc
+{
+	namespace
+	{
+		constexpr float baumgarte = 0.2f;
+		//fraction of the penetration pushed out per step
+		constexpr float penetrationSlop = 0.005f;
+		//penetration left alone, so resting contacts don't jitter
+		constexpr float restitutionThreshold = 1.0f;
+		//approach speed under which contacts don't bounce
+
+		constexpr std::uint32_t largeIsland = 64;
+		//manifolds from which an island is colored rather than solved whole
+		constexpr std::uint32_t manifoldsPerTask = 64;
+		constexpr std::uint32_t manifoldsPerChunk = 16;
+		constexpr std::uint32_t maxColors = 64;
+		//one bit each in a body's color mask
+
+		/**
+		 * @brief Builds two unit tangents orthogonal to a unit normal
+		 */
+		inline void makeTangents(const glm::vec3& normal, glm::vec3& tangent1,
+		                         glm::vec3& tangent2)
+		{
+			if (std::abs(normal.x) >= 0.57735f)
+			{
+				tangent1 = glm::normalize(glm::vec3(normal.y, -normal.x, 0.0f));
+			}
+			else
+			{
+				tangent1 = glm::normalize(glm::vec3(0.0f, normal.z, -normal.y));
+			}
+			//one of the components is at least 1/sqrt(3), so the tangent
+			//never degenerates
+
+			tangent2 = glm::cross(normal, tangent1);
+		}
+	}
+
+	void ContactSolver::solve(BodyStorage& bodies,
+	                          const ContactBuffer& contacts,
+	                          const IslandBuilder& islands, float timestep,
+	                          ThreadPool& threads)
+	{
+		ZoneScoped;
+
+		prepare(bodies, contacts, islands, timestep);
+
+		//small islands run start to end within their task
+		threads.run(m_tasks.size(), [&](std::size_t task)
+		            {
+		            	warmStart(bodies, m_tasks[task]);
+
+		            	for (int i = 0; i < m_iterations; i++)
+		            	{
+		            		iterate(bodies, m_tasks[task]);
+		            	}
+		            });
+
+		//large islands go color by color, so they wait for each other
+		for (const auto& island : m_coloredIslands)
+		{
+			for (std::uint32_t i = 0; i < island.batchCount; i++)
+			{
+				runBatch(bodies, m_batches[island.firstBatch + i], threads,
+				         true);
+			}
+
+			for (int iteration = 0; iteration < m_iterations; iteration++)
+			{
+				for (std::uint32_t i = 0; i < island.batchCount; i++)
+				{
+					runBatch(bodies, m_batches[island.firstBatch + i], threads,
+					         false);
+				}
+			}
+		}
+
+		store(contacts);
+
+		PhysiccPlot("Solver constraints",
+		            static_cast<std::int64_t>(m_bodiesA.size()));
+		PhysiccPlot("Solver batches",
+		            static_cast<std::int64_t>(m_tasks.size()
+		                                      + m_batches.size()));
+	}
+
+	/**
+	 * @brief Turns the contact points into constraints, and fetches the
+	 * impulses they ended the last step with
+	 *
+	 * The small islands come first, grouped into tasks of about
+	 * manifoldsPerTask manifolds, then the large islands, sorted by color.
+	 */
+	void ContactSolver::prepare(BodyStorage& bodies,
+	                            const ContactBuffer& contacts,
+	                            const IslandBuilder& islands, float timestep)
+	{
+		PhysiccZoneFine;
+
+		m_bodiesA.clear();
+		m_bodiesB.clear();
+		m_normals.clear();
+		m_tangents1.clear();
+		m_tangents2.clear();
+		m_masses.clear();
+		m_biases.clear();
+		m_frictions.clear();
+		m_normalImpulses.clear();
+		m_tangentImpulses1.clear();
+		m_tangentImpulses2.clear();
+		m_ranges.clear();
+		m_tasks.clear();
+		m_batches.clear();
+		m_coloredIslands.clear();
+
+		const auto& islandContacts = islands.getContacts();
+		Batch task = {0, 0, true};
+
+		for (const auto& island : islands.getIslands())
+		{
+			if (island.contactCount >= largeIsland)
+			{
+				continue;
+			}
+
+			for (std::uint32_t i = 0; i < island.contactCount; i++)
+			{
+				addManifold(bodies, contacts,
+				            islandContacts[island.firstContact + i], timestep);
+			}
+
+			task.rangeCount = static_cast<std::uint32_t>(m_ranges.size()) -
+			                  task.firstRange;
+
+			if (task.rangeCount >= manifoldsPerTask)
+			{
+				m_tasks.push_back(task);
+				task.firstRange = static_cast<std::uint32_t>(m_ranges.size());
+			}
+		}
+
+		task.rangeCount = static_cast<std::uint32_t>(m_ranges.size()) -
+		                  task.firstRange;
+
+		if (task.rangeCount > 0)
+		{
+			m_tasks.push_back(task);
+		}
+
+		m_bodyColors.assign(bodies.getAwakeCount(), 0);
+
+		for (const auto& island : islands.getIslands())
+		{
+			if (island.contactCount >= largeIsland)
+			{
+				colorIsland(bodies, contacts, island, islands, timestep);
+			}
+		}
+	}
+
+	/**
+	 * @brief Adds the constraints of one manifold, with a range pointing to
+	 * them
+	 */
+	void ContactSolver::addManifold(BodyStorage& bodies,
+	                                const ContactBuffer& contacts,
+	                                std::uint32_t m, float timestep)
+	{
+		const auto& velocities = bodies.getVelocities();
+		const auto& inverseMasses = bodies.getInverseMasses();
+		const auto& frictions = bodies.getFrictions();
+		const auto& restitutions = bodies.getRestitutions();
+
+		const auto& manifold = contacts[m];
+		auto a = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+			static_cast<std::uint32_t>(manifold.first)));
+		auto b = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+			static_cast<std::uint32_t>(manifold.second)));
+		float inverseMass = inverseMasses[a] + inverseMasses[b];
+
+		if (inverseMass == 0.0f)
+		{
+			return;
+		}
+		//two static bodies can't push each other
+
+		std::uint64_t key = (static_cast<std::uint64_t>(manifold.first) << 32) |
+		                    static_cast<std::uint32_t>(manifold.second);
+		CachedManifold& cached = m_cache[key];
+		cached.used = true;
+
+		glm::vec3 tangent1;
+		glm::vec3 tangent2;
+		makeTangents(manifold.normal, tangent1, tangent2);
+
+		float friction = std::sqrt(frictions[a] * frictions[b]);
+		float restitution = std::max(restitutions[a], restitutions[b]);
+		float approach = glm::dot(velocities[b] - velocities[a],
+		                          manifold.normal);
+		float bounce = approach < -restitutionThreshold
+			? -restitution * approach
+			: 0.0f;
+
+		m_ranges.push_back({&cached, m,
+		                    static_cast<std::uint32_t>(m_bodiesA.size()),
+		                    manifold.pointCount});
+
+		for (std::uint32_t i = 0; i < manifold.pointCount; i++)
+		{
+			const auto& point = manifold.points[i];
+			float push = baumgarte / timestep *
+			             std::max(point.penetration - penetrationSlop, 0.0f);
+
+			float normalImpulse = 0.0f;
+			glm::vec3 tangentImpulse(0.0f);
+
+			for (std::uint32_t j = 0; j < cached.pointCount; j++)
+			{
+				if (cached.features[j] == point.feature)
+				{
+					normalImpulse = cached.normalImpulses[j];
+					tangentImpulse = cached.tangentImpulses[j];
+					break;
+				}
+			}
+
+			m_bodiesA.push_back(a);
+			m_bodiesB.push_back(b);
+			m_normals.push_back(manifold.normal);
+			m_tangents1.push_back(tangent1);
+			m_tangents2.push_back(tangent2);
+			m_masses.push_back(1.0f / inverseMass);
+			m_biases.push_back(std::max(bounce, push));
+			m_frictions.push_back(friction);
+			m_normalImpulses.push_back(normalImpulse);
+			m_tangentImpulses1.push_back(glm::dot(tangentImpulse, tangent1));
+			m_tangentImpulses2.push_back(glm::dot(tangentImpulse, tangent2));
+		}
+	}
+
+	/**
+	 * @brief Gives each manifold of an island the first color that neither
+	 * of its dynamic bodies has yet, then adds the manifolds color by color
+	 *
+	 * Each body keeps a mask of the colors of its manifolds. Manifolds that
+	 * find all maxColors colors taken go to a last batch, solved
+	 * sequentially.
+	 */
+	void ContactSolver::colorIsland(BodyStorage& bodies,
+	                                const ContactBuffer& contacts,
+	                                const Island& island,
+	                                const IslandBuilder& islands,
+	                                float timestep)
+	{
+		PhysiccZoneFine;
+
+		const auto& inverseMasses = bodies.getInverseMasses();
+		const auto& islandContacts = islands.getContacts();
+		const auto& islandBodies = islands.getBodies();
+
+		m_manifoldColors.resize(island.contactCount);
+		m_colorOffsets.assign(maxColors + 2, 0);
+
+		for (std::uint32_t i = 0; i < island.contactCount; i++)
+		{
+			std::uint32_t contact = islandContacts[island.firstContact + i];
+			const auto& manifold = contacts[contact];
+			auto a = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+				static_cast<std::uint32_t>(manifold.first)));
+			auto b = static_cast<std::uint32_t>(bodies.getIndexOfSlot(
+				static_cast<std::uint32_t>(manifold.second)));
+
+			//static bodies are only read, so they may be in every color
+			bool dynamicA = inverseMasses[a] != 0.0f;
+			bool dynamicB = inverseMasses[b] != 0.0f;
+			std::uint64_t taken = (dynamicA ? m_bodyColors[a] : 0) |
+			                      (dynamicB ? m_bodyColors[b] : 0);
+
+			std::uint32_t color = 0;
+
+			while (color < maxColors && (taken >> color & 1) != 0)
+			{
+				color++;
+			}
+
+			if (color < maxColors)
+			{
+				std::uint64_t bit = std::uint64_t(1) << color;
+
+				if (dynamicA)
+				{
+					m_bodyColors[a] |= bit;
+				}
+
+				if (dynamicB)
+				{
+					m_bodyColors[b] |= bit;
+				}
+			}
+
+			m_manifoldColors[i] = color;
+			m_colorOffsets[color + 1]++;
+		}
+
+		for (std::uint32_t i = 0; i < island.bodyCount; i++)
+		{
+			m_bodyColors[islandBodies[island.firstBody + i]] = 0;
+		}
+
+		for (std::uint32_t color = 0; color <= maxColors; color++)
+		{
+			m_colorOffsets[color + 1] += m_colorOffsets[color];
+		}
+
+		//the offsets become the ends of the colors as the manifolds land
+		m_coloredManifolds.resize(island.contactCount);
+
+		for (std::uint32_t i = 0; i < island.contactCount; i++)
+		{
+			m_coloredManifolds[m_colorOffsets[m_manifoldColors[i]]++] =
+				islandContacts[island.firstContact + i];
+		}
+
+		ColoredIsland colored = {
+			static_cast<std::uint32_t>(m_batches.size()), 0};
+		std::uint32_t begin = 0;
+
+		for (std::uint32_t color = 0; color <= maxColors; color++)
+		{
+			std::uint32_t end = m_colorOffsets[color];
+
+			if (end == begin)
+			{
+				continue;
+			}
+
+			Batch batch = {static_cast<std::uint32_t>(m_ranges.size()), 0,
+			               color < maxColors};
+
+			for (std::uint32_t i = begin; i < end; i++)
+			{
+				addManifold(bodies, contacts, m_coloredManifolds[i], timestep);
+			}
+
+			batch.rangeCount = static_cast<std::uint32_t>(m_ranges.size()) -
+			                   batch.firstRange;
+			begin = end;
+
+			if (batch.rangeCount > 0)
+			{
+				m_batches.push_back(batch);
+				colored.batchCount++;
+			}
+		}
+
+		m_coloredIslands.push_back(colored);
+	}
+
+	/**
+	 * @brief Runs a batch of a large island, split into chunks over the
+	 * threads if its manifolds share no dynamic body
+	 */
+	void ContactSolver::runBatch(BodyStorage& bodies, const Batch& batch,
+	                             ThreadPool& threads, bool warm)
+	{
+		std::size_t chunks = batch.parallel
+			? (batch.rangeCount + manifoldsPerChunk - 1) / manifoldsPerChunk
+			: 1;
+
+		threads.run(chunks, [&](std::size_t chunk)
+		            {
+		            	auto first = static_cast<std::uint32_t>(
+		            		chunk * manifoldsPerChunk);
+		            	std::uint32_t left = batch.rangeCount - first;
+		            	Batch part = {batch.firstRange + first,
+		            	              batch.parallel
+		            	              	? std::min(manifoldsPerChunk, left)
+		            	              	: batch.rangeCount,
+		            	              batch.parallel};
+
+		            	if (warm)
+		            	{
+		            		warmStart(bodies, part);
+		            	}
+		            	else
+		            	{
+		            		iterate(bodies, part);
+		            	}
+		            });
+	}
+
+	/**
+	 * @brief Applies the impulses carried over from the last step
+	 *
+	 * Only dynamic bodies are written to: static bodies are shared by
+	 * batches that run at the same time.
+	 */
+	void ContactSolver::warmStart(BodyStorage& bodies, const Batch& batch)
+	{
+		PhysiccZoneFine;
+
+		auto& velocities = bodies.getVelocities();
+		const auto& inverseMasses = bodies.getInverseMasses();
+
+		std::uint32_t first = m_ranges[batch.firstRange].first;
+		const auto& last = m_ranges[batch.firstRange + batch.rangeCount - 1];
+
+		for (std::uint32_t i = first; i < last.first + last.count; i++)
+		{
+			std::uint32_t a = m_bodiesA[i];
+			std::uint32_t b = m_bodiesB[i];
+			glm::vec3 impulse = m_normals[i] * m_normalImpulses[i] +
+			                    m_tangents1[i] * m_tangentImpulses1[i] +
+			                    m_tangents2[i] * m_tangentImpulses2[i];
+
+			if (inverseMasses[a] != 0.0f)
+			{
+				velocities[a] -= impulse * inverseMasses[a];
+			}
+
+			if (inverseMasses[b] != 0.0f)
+			{
+				velocities[b] += impulse * inverseMasses[b];
+			}
+		}
+	}
+
+	/**
+	 * @brief Runs one Gauss-Seidel sweep over the constraints of a batch
+	 *
+	 * Friction is solved before the normal, since the normal row matters
+	 * more and the last row solved is the one best satisfied. Impulses are
+	 * clamped as totals (accumulated), not per sweep, so that a sweep can
+	 * undo part of what an earlier one overshot.
+	 */
+	void ContactSolver::iterate(BodyStorage& bodies, const Batch& batch)
+	{
+		PhysiccZoneFine;
+
+		auto& velocities = bodies.getVelocities();
+		const auto& inverseMasses = bodies.getInverseMasses();
+
+		//the constraints of consecutive ranges are consecutive
+		std::uint32_t first = m_ranges[batch.firstRange].first;
+		const auto& last = m_ranges[batch.firstRange + batch.rangeCount - 1];
+
+		for (std::uint32_t i = first; i < last.first + last.count; i++)
+		{
+			std::uint32_t a = m_bodiesA[i];
+			std::uint32_t b = m_bodiesB[i];
+			float inverseMassA = inverseMasses[a];
+			float inverseMassB = inverseMasses[b];
+			float mass = m_masses[i];
+
+			glm::vec3 velocityA = velocities[a];
+			glm::vec3 velocityB = velocities[b];
+			glm::vec3 relative = velocityB - velocityA;
+
+			float maxFriction = m_frictions[i] * m_normalImpulses[i];
+
+			float old1 = m_tangentImpulses1[i];
+			m_tangentImpulses1[i] = std::clamp(
+				old1 - mass * glm::dot(relative, m_tangents1[i]),
+				-maxFriction, maxFriction);
+
+			float old2 = m_tangentImpulses2[i];
+			m_tangentImpulses2[i] = std::clamp(
+				old2 - mass * glm::dot(relative, m_tangents2[i]),
+				-maxFriction, maxFriction);
+
+			glm::vec3 impulse = m_tangents1[i] * (m_tangentImpulses1[i] - old1)
+				+ m_tangents2[i] * (m_tangentImpulses2[i] - old2);
+			velocityA -= impulse * inverseMassA;
+			velocityB += impulse * inverseMassB;
+			relative = velocityB - velocityA;
+
+			float oldNormal = m_normalImpulses[i];
+			float approach = glm::dot(relative, m_normals[i]);
+			m_normalImpulses[i] = std::max(
+				oldNormal + mass * (m_biases[i] - approach), 0.0f);
+
+			impulse = m_normals[i] * (m_normalImpulses[i] - oldNormal);
+			velocityA -= impulse * inverseMassA;
+			velocityB += impulse * inverseMassB;
+
+			if (inverseMassA != 0.0f)
+			{
+				velocities[a] = velocityA;
+			}
+
+			if (inverseMassB != 0.0f)
+			{
+				velocities[b] = velocityB;
+			}
+		}
+	}
+
+	/**
+	 * @brief Saves the accumulated impulses for the next step, and drops
+	 * the manifolds that weren't seen this step
+	 */
+	void ContactSolver::store(const ContactBuffer& contacts)
+	{
+		PhysiccZoneFine;
+
+		for (const auto& range : m_ranges)
+		{
+			CachedManifold& cached = *range.cache;
+			const auto& manifold = contacts[range.manifold];
+			cached.pointCount = range.count;
+
+			for (std::uint32_t i = 0; i < range.count; i++)
+			{
+				std::uint32_t constraint = range.first + i;
+
+				cached.features[i] = manifold.points[i].feature;
+				cached.normalImpulses[i] = m_normalImpulses[constraint];
+				cached.tangentImpulses[i] =
+					m_tangents1[constraint] * m_tangentImpulses1[constraint] +
+					m_tangents2[constraint] * m_tangentImpulses2[constraint];
+			}
+		}
+
+		for (auto it = m_cache.begin(); it != m_cache.end();)
+		{
+			if (it->second.used)
+			{
+				it->second.used = false;
+				++it;
+			}
+			else
+			{
+				it = m_cache.erase(it);
+			}
+		}
+	}
+}
@@ -0,0 +1,281 @@
+/**
+ * @file spatialhash.cpp
+ * @brief A uniform grid broadphase stored in an open addressing hash table.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* spatialhash header */
+
+#include "tools/Tracy.hpp"
+
+#include "spatialhash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Physicc
+{
+	namespace
+	{
+		constexpr std::uint32_t nullIndex = ~std::uint32_t(0);
+
+		//Bodies touching more cells than this are tested against everything
+		//instead, so a single huge body can't flood the table
+		constexpr std::int64_t maxCellsPerBody = 64;
+
+		//Cell coordinates past this don't fit an int, so bodies reaching
+		//them are treated as too large for the table
+		constexpr float maxCellCoordinate = 1073741824.0f;
+
+		inline std::uint32_t hashCell(const glm::ivec3& cell)
+		{
+			//the usual large primes for hashing grid coordinates
+			return (static_cast<std::uint32_t>(cell.x) * 73856093u)
+				^ (static_cast<std::uint32_t>(cell.y) * 19349663u)
+				^ (static_cast<std::uint32_t>(cell.z) * 83492791u);
+		}
+	}
+
+	SpatialHash::SpatialHash(float cellSize)
+		: m_stamp(0), m_cellSize(cellSize)
+	{
+	}
+
+	void SpatialHash::insert(std::size_t body,
+	                         const BoundingVolume::AABB& volume)
+	{
+		if (body >= m_volumes.size())
+		{
+			m_volumes.resize(body + 1);
+			m_tracked.resize(body + 1, false);
+		}
+
+		m_volumes[body] = volume;
+		m_tracked[body] = true;
+	}
+
+	void SpatialHash::remove(std::size_t body)
+	{
+		m_tracked[body] = false;
+	}
+
+	void SpatialHash::update(std::size_t body,
+	                         const BoundingVolume::AABB& volume)
+	{
+		m_volumes[body] = volume;
+	}
+
+	float SpatialHash::computeCellSize() const
+	{
+		float sum = 0.0f;
+		float count = 0.0f;
+
+		for (std::size_t body = 0; body < m_volumes.size(); body++)
+		{
+			if (m_tracked[body])
+			{
+				glm::vec3 extent = m_volumes[body].getUpperBound()
+					- m_volumes[body].getLowerBound();
+				sum += std::max(extent.x, std::max(extent.y, extent.z));
+				count += 1.0f;
+			}
+		}
+
+		return (count == 0.0f || sum == 0.0f) ? 1.0f : sum / count;
+	}
+
+	/**
+	 * @brief Makes sure the table has room for cellCount distinct cells
+	 *
+	 * The table is kept at most half full to keep probe sequences short. It
+	 * only ever grows, so in steady state this never allocates.
+	 */
+	void SpatialHash::reserveSlots(std::size_t cellCount)
+	{
+		std::size_t size = m_slots.empty() ? 64 : m_slots.size();
+
+		while (size < 2 * cellCount)
+		{
+			size *= 2;
+		}
+
+		if (size != m_slots.size())
+		{
+			m_slots.assign(size, Slot());
+			m_stamp = 0;
+		}
+	}
+
+	void SpatialHash::addToCell(const glm::ivec3& cell, std::uint32_t body)
+	{
+		auto mask = static_cast<std::uint32_t>(m_slots.size() - 1);
+		std::uint32_t index = hashCell(cell) & mask;
+
+		//linear probing until either the cell or an empty slot is found
+		while (m_slots[index].stamp == m_stamp && m_slots[index].cell != cell)
+		{
+			index = (index + 1) & mask;
+		}
+
+		auto& slot = m_slots[index];
+
+		if (slot.stamp != m_stamp)
+		{
+			slot.cell = cell;
+			slot.stamp = m_stamp;
+			slot.first = nullIndex;
+			m_usedSlots.push_back(index);
+		}
+
+		m_entries.push_back({body, slot.first});
+		slot.first = static_cast<std::uint32_t>(m_entries.size() - 1);
+	}
+
+	void SpatialHash::findPairs(std::vector<CollisionPair>& pairs)
+	{
+		ZoneScoped;
+
+		pairs.clear();
+		m_entries.clear();
+		m_usedSlots.clear();
+		m_large.clear();
+		PhysiccCounter(pairsTested);
+
+		float inverseCellSize = 1.0f / (m_cellSize > 0.0f
+		                                ? m_cellSize
+		                                : computeCellSize());
+
+		auto cellRange = [&](std::size_t body, glm::ivec3& low,
+		                     glm::ivec3& high) -> std::int64_t {
+			glm::vec3 lower = glm::floor(m_volumes[body].getLowerBound()
+			                             * inverseCellSize);
+			glm::vec3 upper = glm::floor(m_volumes[body].getUpperBound()
+			                             * inverseCellSize);
+			glm::vec3 limit(maxCellCoordinate);
+
+			//also false for infinite and NaN bounds
+			if (!glm::all(glm::lessThanEqual(glm::abs(lower), limit))
+			    || !glm::all(glm::lessThanEqual(glm::abs(upper), limit)))
+			{
+				return maxCellsPerBody + 1;
+			}
+
+			low = glm::ivec3(lower);
+			high = glm::ivec3(upper);
+			glm::i64vec3 span = glm::i64vec3(high) - glm::i64vec3(low)
+				+ std::int64_t(1);
+			span = glm::min(span, glm::i64vec3(maxCellsPerBody + 1));
+			//so that the product can't overflow either
+
+			return span.x * span.y * span.z;
+		};
+
+		//First pass: count the cells to size the table, so that it never
+		//has to be rehashed while it is being filled
+		std::size_t cellCount = 0;
+		glm::ivec3 low, high;
+
+		for (std::size_t body = 0; body < m_volumes.size(); body++)
+		{
+			if (!m_tracked[body])
+			{
+				continue;
+			}
+
+			std::int64_t count = cellRange(body, low, high);
+
+			if (count > maxCellsPerBody)
+			{
+				m_large.push_back(static_cast<std::uint32_t>(body));
+			} else
+			{
+				cellCount += static_cast<std::size_t>(count);
+			}
+		}
+
+		reserveSlots(cellCount);
+
+		//Bumping the stamp empties every slot at once
+		if (++m_stamp == 0)
+		{
+			for (auto& slot : m_slots)
+			{
+				slot.stamp = 0;
+			}
+
+			m_stamp = 1;
+		}
+
+		{
+			ZoneScopedN("SpatialHash::fill");
+
+			for (std::size_t body = 0; body < m_volumes.size(); body++)
+			{
+				if (!m_tracked[body]
+				    || cellRange(body, low, high) > maxCellsPerBody)
+				{
+					continue;
+				}
+
+				for (int x = low.x; x <= high.x; x++)
+				{
+					for (int y = low.y; y <= high.y; y++)
+					{
+						for (int z = low.z; z <= high.z; z++)
+						{
+							addToCell({x, y, z},
+							          static_cast<std::uint32_t>(body));
+						}
+					}
+				}
+			}
+		}
+
+		for (auto index : m_usedSlots)
+		{
+			for (auto a = m_slots[index].first; a != nullIndex;
+			     a = m_entries[a].next)
+			{
+				std::uint32_t bodyA = m_entries[a].body;
+
+				for (auto b = m_entries[a].next; b != nullIndex;
+				     b = m_entries[b].next)
+				{
+					std::uint32_t bodyB = m_entries[b].body;
+					PhysiccCount(pairsTested, 1);
+
+					if (m_volumes[bodyA].overlapsWith(m_volumes[bodyB]))
+					{
+						pairs.push_back({std::min(bodyA, bodyB),
+						                 std::max(bodyA, bodyB)});
+					}
+				}
+			}
+		}
+
+		for (auto large : m_large)
+		{
+			PhysiccCount(pairsTested, m_volumes.size());
+
+			for (std::size_t body = 0; body < m_volumes.size(); body++)
+			{
+				if (m_tracked[body] && body != large
+				    && m_volumes[large].overlapsWith(m_volumes[body]))
+				{
+					pairs.push_back({std::min<std::size_t>(large, body),
+					                 std::max<std::size_t>(large, body)});
+				}
+			}
+		}
+
+		//Bodies sharing several cells are found once per shared cell, so
+		//sort the pairs (which also makes them cache friendly to walk in
+		//body order) and drop the duplicates
+		std::sort(pairs.begin(), pairs.end());
+		pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+		PhysiccPlot("SpatialHash pairs tested", pairsTested);
+	}
+}
@@ -0,0 +1,201 @@
+/**
+ * @file sweepandprune.cpp
+ * @brief A sort and sweep broadphase with persistent endpoint arrays.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* sweepandprune header */
+
+#include "tools/Tracy.hpp"
+
+#include "sweepandprune.hpp"
+
+#include <algorithm>
+
+namespace Physicc
+{
+	SweepAndPrune::SweepAndPrune() : m_axis(0), m_needsSort(false)
+	{
+	}
+
+	void SweepAndPrune::insert(std::size_t body,
+	                           const BoundingVolume::AABB& volume)
+	{
+		if (body >= m_volumes.size())
+		{
+			m_volumes.resize(body + 1);
+			m_tracked.resize(body + 1, false);
+		}
+
+		m_volumes[body] = volume;
+		m_tracked[body] = true;
+
+		auto id = static_cast<std::uint32_t>(body);
+		m_endpoints.push_back({volume.getLowerBound()[m_axis], id, true});
+		m_endpoints.push_back({volume.getUpperBound()[m_axis], id, false});
+
+		//New endpoints can be anywhere in the array, so insertion sorting
+		//them one by one could be quadratic when many bodies are added at
+		//once
+		m_needsSort = true;
+	}
+
+	void SweepAndPrune::remove(std::size_t body)
+	{
+		m_tracked[body] = false;
+
+		auto id = static_cast<std::uint32_t>(body);
+		m_endpoints.erase(std::remove_if(m_endpoints.begin(), m_endpoints.end(),
+		                                 [id](const Endpoint& endpoint) {
+		                                   return endpoint.body == id;
+		                                 }),
+		                  m_endpoints.end());
+	}
+
+	void SweepAndPrune::update(std::size_t body,
+	                           const BoundingVolume::AABB& volume)
+	{
+		m_volumes[body] = volume;
+	}
+
+	/**
+	 * @brief Returns the axis along which the bodies are spread out the most
+	 *
+	 * Sweeping along the axis with the highest centroid variance keeps the
+	 * number of bodies whose intervals overlap on that axis (and which must
+	 * therefore be tested on the other two) as low as possible.
+	 */
+	int SweepAndPrune::chooseAxis() const
+	{
+		glm::vec3 sum(0.0f), sumSquares(0.0f);
+		float count = 0.0f;
+
+		for (std::size_t body = 0; body < m_volumes.size(); body++)
+		{
+			if (!m_tracked[body])
+			{
+				continue;
+			}
+
+			glm::vec3 centroid = 0.5f * (m_volumes[body].getLowerBound()
+			                             + m_volumes[body].getUpperBound());
+			sum += centroid;
+			sumSquares += centroid * centroid;
+			count += 1.0f;
+		}
+
+		if (count == 0.0f)
+		{
+			return m_axis;
+		}
+
+		glm::vec3 variance = sumSquares / count - (sum / count) * (sum / count);
+
+		if (variance.x >= variance.y && variance.x >= variance.z)
+		{
+			return 0;
+		} else if (variance.y >= variance.z)
+		{
+			return 1;
+		}
+
+		return 2;
+	}
+
+	/**
+	 * @brief Brings the endpoint array up to date with the bodies' volumes
+	 *
+	 * Uses an insertion sort, which runs in O(n + k) for k swapped pairs of
+	 * endpoints. Thanks to temporal coherence k is small in most frames.
+	 */
+	void SweepAndPrune::sortEndpoints()
+	{
+		ZoneScoped;
+
+		int axis = chooseAxis();
+
+		if (axis != m_axis)
+		{
+			m_axis = axis;
+			m_needsSort = true;
+			//the old order says nothing about the order on the new axis
+		}
+
+		for (auto& endpoint : m_endpoints)
+		{
+			const auto& volume = m_volumes[endpoint.body];
+			endpoint.value = endpoint.isMin
+				? volume.getLowerBound()[m_axis]
+				: volume.getUpperBound()[m_axis];
+		}
+
+		if (m_needsSort)
+		{
+			std::sort(m_endpoints.begin(), m_endpoints.end());
+			m_needsSort = false;
+			return;
+		}
+
+		for (std::size_t i = 1; i < m_endpoints.size(); i++)
+		{
+			Endpoint endpoint = m_endpoints[i];
+			std::size_t j = i;
+
+			while (j > 0 && endpoint < m_endpoints[j - 1])
+			{
+				m_endpoints[j] = m_endpoints[j - 1];
+				j--;
+			}
+
+			m_endpoints[j] = endpoint;
+		}
+	}
+
+	void SweepAndPrune::findPairs(std::vector<CollisionPair>& pairs)
+	{
+		ZoneScoped;
+
+		pairs.clear();
+		sortEndpoints();
+
+		m_active.clear();
+		m_activeVolumes.clear();
+		m_activeIndex.resize(m_volumes.size());
+		PhysiccCounter(pairsTested);
+
+		for (const auto& endpoint : m_endpoints)
+		{
+			if (!endpoint.isMin)
+			{
+				//swap the body with the last active one, and pop it
+				std::uint32_t index = m_activeIndex[endpoint.body];
+				m_active[index] = m_active.back();
+				m_activeIndex[m_active[index]] = index;
+				m_active.pop_back();
+				m_activeVolumes.swapRemove(index);
+				continue;
+			}
+
+			const auto& volume = m_volumes[endpoint.body];
+
+			//Every active body already overlaps this one on the sweep axis,
+			//but the full test is just as cheap as testing the remaining two
+			//axes
+			PhysiccCount(pairsTested, m_active.size());
+			m_activeVolumes.forEachOverlap(volume, [&](std::size_t index) {
+				std::uint32_t other = m_active[index];
+				pairs.push_back({std::min<std::size_t>(endpoint.body, other),
+				                 std::max<std::size_t>(endpoint.body, other)});
+			});
+
+			m_activeIndex[endpoint.body] =
+				static_cast<std::uint32_t>(m_active.size());
+			m_active.push_back(endpoint.body);
+			m_activeVolumes.push_back(volume);
+		}
+
+		PhysiccPlot("SweepAndPrune pairs tested", pairsTested);
+	}
+}
@@ -0,0 +1,135 @@
+/**
+ * @file threadpool.cpp
+ * @brief Persistent worker threads for parallel loops.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* threadpool header */
+
+#include "tools/Tracy.hpp"
+
+#include "threadpool.hpp"
+
+namespace Physicc
+{
+	ThreadPool::ThreadPool(std::size_t workerCount)
+	{
+		m_workers.reserve(workerCount);
+
+		for (std::size_t i = 0; i < workerCount; i++)
+		{
+			m_workers.emplace_back(&ThreadPool::work, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+
+		m_started.notify_all();
+
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::dispatch(std::size_t count, Function function,
+	                          const void* context)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			//a worker that woke up late for the last loop may still be in
+			//it: the loop counter can't be reset under its feet
+			m_finished.wait(lock, [this]
+			                {
+			                	return m_busy == 0;
+			                });
+
+			m_function = function;
+			m_context = context;
+			m_count = count;
+			m_done = 0;
+			m_next.store(0, std::memory_order_relaxed);
+			m_generation++;
+		}
+
+		m_started.notify_all();
+
+		std::size_t done = execute(function, context, count);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done += done;
+		m_finished.wait(lock, [this]
+		                {
+		                	return m_done == m_count;
+		                });
+	}
+
+	void ThreadPool::work()
+	{
+		std::uint64_t generation = 0;
+
+		while (true)
+		{
+			Function function;
+			const void* context;
+			std::size_t count;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_started.wait(lock, [&]
+				               {
+				               	return m_stopping || m_generation != generation;
+				               });
+
+				if (m_stopping)
+				{
+					return;
+				}
+
+				generation = m_generation;
+				function = m_function;
+				context = m_context;
+				count = m_count;
+				m_busy++;
+			}
+
+			std::size_t done = execute(function, context, count);
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_done += done;
+				m_busy--;
+			}
+
+			m_finished.notify_all();
+		}
+	}
+
+	/**
+	 * @brief Runs indices of the current loop until there are none left
+	 *
+	 * @return The number of indices run
+	 */
+	std::size_t ThreadPool::execute(Function function, const void* context,
+	                                std::size_t count)
+	{
+		std::size_t done = 0;
+		std::size_t index;
+
+		while ((index = m_next.fetch_add(1, std::memory_order_relaxed)) < count)
+		{
+			function(context, index);
+			done++;
+		}
+
+		return done;
+	}
+}
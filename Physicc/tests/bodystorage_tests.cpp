@@ -0,0 +1,137 @@
+/**
+ * @file bodystorage_tests.cpp
+ * @brief Tests of the allocation behaviour of BodyStorage.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* gtest header */
+
+#include "tools/Tracy.hpp"
+
+#include "gtest/gtest.h"
+#include "bodystorage.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace
+{
+	bool counting = false;
+	std::size_t allocations = 0;
+	//only allocations made while counting is set are recorded, so gtest's
+	//own bookkeeping does not show up
+
+	void* allocate(std::size_t size, std::size_t alignment)
+	{
+		if (counting)
+		{
+			allocations++;
+		}
+
+		size = (size + alignment - 1) / alignment * alignment;
+		//aligned_alloc wants a multiple of the alignment
+		void* pointer = alignment > alignof(std::max_align_t)
+			? std::aligned_alloc(alignment, size ? size : alignment)
+			: std::malloc(size ? size : 1);
+
+		if (!pointer)
+		{
+			throw std::bad_alloc();
+		}
+
+		return pointer;
+	}
+
+	std::vector<Physicc::RigidBody> makeBodies(std::size_t count)
+	{
+		std::vector<Physicc::RigidBody> bodies;
+		bodies.reserve(count);
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			Physicc::RigidBody body(1.0f, glm::vec3(0.0f), 1.0f);
+			body.setCollider(Physicc::BoxCollider(glm::vec3(i, 0.0f, 0.0f)));
+			bodies.push_back(body);
+		}
+
+		return bodies;
+	}
+
+	/**
+	 * @brief Counts the allocations made while adding bodies to storage
+	 */
+	std::size_t countAddAllocations(Physicc::BodyStorage& storage,
+		const std::vector<Physicc::RigidBody>& bodies)
+	{
+		allocations = 0;
+		counting = true;
+
+		for (auto& body : bodies)
+		{
+			storage.add(body);
+		}
+
+		counting = false;
+
+		return allocations;
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate(size, 1);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+//AlignedAllocator, and so most of BodyStorage's arrays, goes through this one
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+	std::free(pointer);
+}
+
+TEST(BodyStorage, AddAfterReserveDoesNotAllocate)
+{
+	constexpr std::size_t count = 100000;
+	auto bodies = makeBodies(count);
+
+	Physicc::BodyStorage storage;
+	storage.reserve(count);
+
+	EXPECT_EQ(countAddAllocations(storage, bodies), 0u);
+	EXPECT_EQ(storage.size(), count);
+}
+
+TEST(BodyStorage, AddWithoutReserveAllocates)
+{
+	//makes sure the counting above can fail at all
+	constexpr std::size_t count = 100000;
+	auto bodies = makeBodies(count);
+
+	Physicc::BodyStorage storage;
+
+	EXPECT_GT(countAddAllocations(storage, bodies), 0u);
+	EXPECT_EQ(storage.size(), count);
+}
@@ -0,0 +1,243 @@
+/**
+ * @file narrowphase_tests.cpp
+ * @brief Tests of the contacts generated for each pair of shapes.
+ *
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+/* gtest header */
+
+#include "tools/Tracy.hpp"
+
+#include "gtest/gtest.h"
+#include "narrowphase.hpp"
+
+#include <set>
+
+namespace
+{
+	constexpr float tolerance = 1e-4f;
+	constexpr float eighthTurn = 45.0f;
+	//colliders are rotated in degrees
+
+	/**
+	 * @brief Collides a and b as the pair (0, 1)
+	 */
+	bool collide(const Physicc::Collider& a, const Physicc::Collider& b,
+	             Physicc::ContactManifold& manifold)
+	{
+		Physicc::Narrowphase narrowphase;
+		manifold.first = 0;
+		manifold.second = 1;
+
+		return narrowphase.collide(a, b, manifold);
+	}
+
+	void expectVec3Near(const glm::vec3& actual, const glm::vec3& expected)
+	{
+		EXPECT_NEAR(actual.x, expected.x, tolerance);
+		EXPECT_NEAR(actual.y, expected.y, tolerance);
+		EXPECT_NEAR(actual.z, expected.z, tolerance);
+	}
+
+	std::set<std::uint32_t>
+	getFeatures(const Physicc::ContactManifold& manifold)
+	{
+		std::set<std::uint32_t> features;
+
+		for (std::uint32_t i = 0; i < manifold.pointCount; i++)
+		{
+			features.insert(manifold.points[i].feature);
+		}
+
+		return features;
+	}
+}
+
+TEST(NarrowphaseBoxBox, FaceContactHasFourPoints)
+{
+	Physicc::BoxCollider a(glm::vec3(0.0f));
+	Physicc::BoxCollider b(glm::vec3(0.2f, 0.9f, 0.1f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(a, b, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(0.0f, 1.0f, 0.0f));
+	ASSERT_EQ(manifold.pointCount, 4u);
+
+	for (std::uint32_t i = 0; i < manifold.pointCount; i++)
+	{
+		const auto& point = manifold.points[i];
+		EXPECT_NEAR(point.penetration, 0.1f, tolerance);
+		EXPECT_NEAR(point.position.y, 0.45f, tolerance);
+		//halfway between the top face of a and the bottom face of b
+		EXPECT_EQ(point.feature >> 16, 1u);
+		//the y face of a is the reference face
+	}
+
+	EXPECT_EQ(getFeatures(manifold).size(), 4u);
+}
+
+TEST(NarrowphaseBoxBox, FaceContactFeaturesSurviveSliding)
+{
+	Physicc::BoxCollider a(glm::vec3(0.0f));
+	Physicc::BoxCollider b(glm::vec3(0.2f, 0.9f, 0.1f));
+	Physicc::BoxCollider moved(glm::vec3(0.25f, 0.9f, 0.05f));
+	Physicc::ContactManifold before, after;
+
+	ASSERT_TRUE(collide(a, b, before));
+	ASSERT_TRUE(collide(a, moved, after));
+	EXPECT_EQ(getFeatures(before), getFeatures(after));
+}
+
+TEST(NarrowphaseBoxBox, NormalPointsFromFirstToSecond)
+{
+	Physicc::BoxCollider a(glm::vec3(0.0f));
+	Physicc::BoxCollider b(glm::vec3(-0.95f, 0.0f, 0.0f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(a, b, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(-1.0f, 0.0f, 0.0f));
+	ASSERT_EQ(manifold.pointCount, 4u);
+	EXPECT_NEAR(manifold.points[0].penetration, 0.05f, tolerance);
+}
+
+TEST(NarrowphaseBoxBox, EdgeContactHasOnePoint)
+{
+	//a's top edge runs along z, b's bottom edge runs along x, and they
+	//cross 0.1142 deep
+	Physicc::BoxCollider a(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, eighthTurn));
+	Physicc::BoxCollider b(glm::vec3(0.0f, 1.3f, 0.0f),
+	                       glm::vec3(eighthTurn, 0.0f, 0.0f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(a, b, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(0.0f, 1.0f, 0.0f));
+	ASSERT_EQ(manifold.pointCount, 1u);
+
+	float depth = 2.0f * 0.70710678f - 1.3f;
+	EXPECT_NEAR(manifold.points[0].penetration, depth, tolerance);
+	expectVec3Near(manifold.points[0].position,
+	               glm::vec3(0.0f, 0.70710678f - 0.5f * depth, 0.0f));
+	EXPECT_GE(manifold.points[0].feature >> 16, 6u);
+	//edge pairs come after the 6 face axes
+}
+
+TEST(NarrowphaseBoxBox, SeparatedBoxesDontCollide)
+{
+	Physicc::BoxCollider a(glm::vec3(0.0f));
+	Physicc::BoxCollider beside(glm::vec3(1.01f, 0.0f, 0.0f));
+	Physicc::BoxCollider far(glm::vec3(3.0f));
+	Physicc::ContactManifold manifold;
+
+	EXPECT_FALSE(collide(a, beside, manifold));
+	EXPECT_FALSE(collide(a, far, manifold));
+
+	//crossed edges 0.1 apart: the face axes overlap, and only the axis
+	//across both edges separates the boxes
+	Physicc::BoxCollider c(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, eighthTurn));
+	Physicc::BoxCollider d(glm::vec3(0.0f, 2.0f * 0.70710678f + 0.1f, 0.0f),
+	                       glm::vec3(eighthTurn, 0.0f, 0.0f));
+
+	EXPECT_FALSE(collide(c, d, manifold));
+}
+
+TEST(NarrowphaseBoxSphere, SphereOnFace)
+{
+	Physicc::BoxCollider box(glm::vec3(0.0f));
+	Physicc::SphereCollider sphere(0.5f, glm::vec3(0.0f, 0.9f, 0.0f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(box, sphere, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(0.0f, 1.0f, 0.0f));
+	ASSERT_EQ(manifold.pointCount, 1u);
+	EXPECT_NEAR(manifold.points[0].penetration, 0.1f, tolerance);
+	expectVec3Near(manifold.points[0].position, glm::vec3(0.0f, 0.45f, 0.0f));
+	EXPECT_EQ(manifold.points[0].feature, 0u);
+}
+
+TEST(NarrowphaseBoxSphere, SphereOnCorner)
+{
+	Physicc::BoxCollider box(glm::vec3(0.0f));
+	Physicc::SphereCollider sphere(0.5f, glm::vec3(0.75f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(box, sphere, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(0.57735027f));
+	ASSERT_EQ(manifold.pointCount, 1u);
+	EXPECT_NEAR(manifold.points[0].penetration,
+	            0.5f - 0.25f * 1.7320508f, tolerance);
+	//the radius minus the distance from the center to the corner
+}
+
+TEST(NarrowphaseBoxSphere, CenterInsideBoxPushesOutThroughNearestFace)
+{
+	Physicc::BoxCollider box(glm::vec3(0.0f));
+	Physicc::SphereCollider sphere(0.5f, glm::vec3(0.1f, 0.0f, -0.3f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(box, sphere, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(0.0f, 0.0f, -1.0f));
+	ASSERT_EQ(manifold.pointCount, 1u);
+	EXPECT_NEAR(manifold.points[0].penetration, 0.5f + 0.2f, tolerance);
+	//the radius plus the depth of the center under the -z face
+}
+
+TEST(NarrowphaseBoxSphere, SphereFirstFlipsTheNormal)
+{
+	Physicc::BoxCollider box(glm::vec3(0.0f));
+	Physicc::SphereCollider sphere(0.5f, glm::vec3(0.0f, 0.9f, 0.0f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(sphere, box, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(0.0f, -1.0f, 0.0f));
+	EXPECT_NEAR(manifold.points[0].penetration, 0.1f, tolerance);
+}
+
+TEST(NarrowphaseBoxSphere, SeparatedSphereDoesntCollide)
+{
+	Physicc::BoxCollider box(glm::vec3(0.0f));
+	Physicc::SphereCollider side(0.5f, glm::vec3(0.0f, 1.01f, 0.0f));
+	Physicc::SphereCollider corner(0.5f, glm::vec3(0.85f));
+	//inside the corner's AABB, but not touching the corner
+	Physicc::ContactManifold manifold;
+
+	EXPECT_FALSE(collide(box, side, manifold));
+	EXPECT_FALSE(collide(box, corner, manifold));
+}
+
+TEST(NarrowphaseSphereSphere, Overlapping)
+{
+	Physicc::SphereCollider a(0.5f, glm::vec3(0.0f));
+	Physicc::SphereCollider b(0.5f, glm::vec3(0.8f, 0.0f, 0.0f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(a, b, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(1.0f, 0.0f, 0.0f));
+	ASSERT_EQ(manifold.pointCount, 1u);
+	EXPECT_NEAR(manifold.points[0].penetration, 0.2f, tolerance);
+	expectVec3Near(manifold.points[0].position, glm::vec3(0.4f, 0.0f, 0.0f));
+	EXPECT_EQ(manifold.points[0].feature, 0u);
+}
+
+TEST(NarrowphaseSphereSphere, ConcentricSpheresGetAFixedNormal)
+{
+	Physicc::SphereCollider a(0.5f, glm::vec3(1.0f));
+	Physicc::SphereCollider b(0.25f, glm::vec3(1.0f));
+	Physicc::ContactManifold manifold;
+
+	ASSERT_TRUE(collide(a, b, manifold));
+	expectVec3Near(manifold.normal, glm::vec3(0.0f, 1.0f, 0.0f));
+	ASSERT_EQ(manifold.pointCount, 1u);
+	EXPECT_NEAR(manifold.points[0].penetration, 0.75f, tolerance);
+}
+
+TEST(NarrowphaseSphereSphere, SeparatedSpheresDontCollide)
+{
+	Physicc::SphereCollider a(0.5f, glm::vec3(0.0f));
+	Physicc::SphereCollider b(0.5f, glm::vec3(0.6f, 0.6f, 0.6f));
+	//inside each other's AABB, 1.039 apart
+	Physicc::ContactManifold manifold;
+
+	EXPECT_FALSE(collide(a, b, manifold));
+}